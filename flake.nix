@@ -14,6 +14,7 @@
         dependencies = with pkgs; [
           ns-3
           yaml-cpp
+          sqlite
         ];
 
         buildTools = with pkgs; [
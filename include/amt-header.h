@@ -0,0 +1,181 @@
+#ifndef CAPSTONE_AMT_HEADER_H
+#define CAPSTONE_AMT_HEADER_H
+
+#include <ns3/buffer.h>
+#include <ns3/header.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/type-id.h>
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// AMT message header (RFC 7450, section 5.1). Only the fixed part of each
+// message is covered; encapsulated IGMP/MLD messages and multicast datagrams
+// stay in the packet payload. The exception is the Membership Query: with G
+// set its gateway port and address follow the encapsulated General Query, so
+// the header carries that query (IPv4 or IPv6, sized from its own IP header)
+// as opaque bytes. Relay and gateway addresses are IPv4, carried as
+// IPv4-mapped IPv6 addresses where the message format reserves 16 bytes.
+class AmtHeader : public ns3::Header
+{
+  public:
+    enum MessageType : uint8_t
+    {
+        RELAY_DISCOVERY = 1,
+        RELAY_ADVERTISEMENT = 2,
+        REQUEST = 3,
+        MEMBERSHIP_QUERY = 4,
+        MEMBERSHIP_UPDATE = 5,
+        MULTICAST_DATA = 6,
+        TEARDOWN = 7,
+    };
+
+    static constexpr uint8_t VERSION = 0;
+
+    static ns3::TypeId GetTypeId();
+    ns3::TypeId GetInstanceTypeId() const override;
+
+    AmtHeader();
+    explicit AmtHeader(MessageType type);
+
+    void Print(std::ostream& os) const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(ns3::Buffer::Iterator start) const override;
+    uint32_t Deserialize(ns3::Buffer::Iterator start) override;
+
+    // False when the last Deserialize saw an unknown version or type, or a
+    // message shorter than its fixed part plus any encapsulated query and
+    // gateway fields.
+    bool IsValid() const
+    {
+        return m_valid;
+    }
+
+    MessageType GetType() const
+    {
+        return m_type;
+    }
+
+    void SetType(MessageType type)
+    {
+        m_type = type;
+    }
+
+    uint8_t GetVersion() const
+    {
+        return m_version;
+    }
+
+    uint32_t GetNonce() const
+    {
+        return m_nonce;
+    }
+
+    void SetNonce(uint32_t nonce)
+    {
+        m_nonce = nonce;
+    }
+
+    uint64_t GetResponseMac() const
+    {
+        return m_responseMac;
+    }
+
+    void SetResponseMac(uint64_t mac)
+    {
+        m_responseMac = mac & 0xffffffffffff;
+    }
+
+    ns3::Ipv4Address GetRelayAddress() const
+    {
+        return m_relayAddress;
+    }
+
+    void SetRelayAddress(ns3::Ipv4Address address)
+    {
+        m_relayAddress = address;
+    }
+
+    bool GetP() const
+    {
+        return m_p;
+    }
+
+    void SetP(bool p)
+    {
+        m_p = p;
+    }
+
+    bool GetL() const
+    {
+        return m_l;
+    }
+
+    void SetL(bool l)
+    {
+        m_l = l;
+    }
+
+    bool GetG() const
+    {
+        return m_g;
+    }
+
+    void SetG(bool g)
+    {
+        m_g = g;
+    }
+
+    uint16_t GetGatewayPort() const
+    {
+        return m_gatewayPort;
+    }
+
+    void SetGatewayPort(uint16_t port)
+    {
+        m_gatewayPort = port;
+    }
+
+    ns3::Ipv4Address GetGatewayAddress() const
+    {
+        return m_gatewayAddress;
+    }
+
+    void SetGatewayAddress(ns3::Ipv4Address address)
+    {
+        m_gatewayAddress = address;
+    }
+
+    // Encapsulated IGMP/MLD General Query of a Membership Query, including
+    // its IP header.
+    const std::vector<uint8_t>& GetEncapsulatedQuery() const
+    {
+        return m_query;
+    }
+
+    void SetEncapsulatedQuery(const std::vector<uint8_t>& query)
+    {
+        m_query = query;
+    }
+
+  private:
+    MessageType m_type;
+    uint8_t m_version;
+    bool m_valid;
+
+    uint32_t m_nonce;
+    uint64_t m_responseMac;
+    ns3::Ipv4Address m_relayAddress;
+    bool m_p;
+    bool m_l;
+    bool m_g;
+    uint16_t m_gatewayPort;
+    ns3::Ipv4Address m_gatewayAddress;
+    std::vector<uint8_t> m_query;
+
+    static uint32_t FixedSize(MessageType type);
+    static uint32_t QueryLength(ns3::Buffer::Iterator i);
+};
+
+#endif
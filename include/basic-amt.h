@@ -1,15 +1,40 @@
 #ifndef CAPSTONE_BASIC_AMT_H
 #define CAPSTONE_BASIC_AMT_H
 
+#include "amt-header.h"
+
 #include <ns3/application.h>
+#include <ns3/event-id.h>
 #include <ns3/inet-socket-address.h>
 #include <ns3/int64x64-128.h>
 #include <ns3/ipv4-address.h>
+#include <ns3/ipv4-header.h>
+#include <ns3/ipv4-l3-protocol.h>
+#include <ns3/nstime.h>
+#include <ns3/random-variable-stream.h>
 #include <ns3/socket.h>
 #include <ns3/type-id.h>
 
+#include <bitset>
 #include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+// AMT relay. Multicast datagrams of the configured group are picked up with
+// a raw socket and encapsulated towards every tunnel. Tunnels are either
+// static (Setup with a gateway address) or built by gateways through the
+// RFC 7450 discovery, request/query/update handshake on the AMT port.
+//
+// Each tunnel has an MTU, either the Mtu attribute or the path MTU towards
+// the gateway, looked up the first time the tunnel carries data. Datagrams
+// whose encapsulated size exceeds it are dropped and counted when
+// DropOversize is set. Those sent above the path MTU are counted as
+// fragmented somewhere on the path. Separately, the fragments the relay's
+// own IP layer sends are counted on the node's transmit trace.
 class RelayApp : public ns3::Application
 {
   public:
@@ -22,24 +47,138 @@ class RelayApp : public ns3::Application
                uint16_t gatewayPort,
                ns3::Ipv4Address multicastGroup,
                uint16_t multicastPort);
+    void Setup(ns3::Ipv4Address multicastGroup, uint16_t multicastPort);
+
+    // Address returned in Relay Advertisement messages.
+    void SetRelayAddress(ns3::Ipv4Address relayAddress);
+
+    // Path MTU lookup towards a gateway. Without one the MTU of the egress
+    // interface is used.
+    void SetPathMtuCallback(std::function<uint32_t(ns3::Ipv4Address)> pathMtu);
+
+    ns3::Ipv4Address GetRelayAddress() const
+    {
+        return m_relayAddress;
+    }
+
+    uint64_t GetTotalPackets() const
+    {
+        return m_totalPackets;
+    }
+
+    uint64_t GetTotalBytes() const
+    {
+        return m_totalBytes;
+    }
+
+    uint32_t GetPeakTunnels() const
+    {
+        return m_peakTunnels;
+    }
+
+    uint32_t GetTunnelSetups() const
+    {
+        return m_tunnelSetups;
+    }
+
+    uint32_t GetMinTunnelMtu() const
+    {
+        return m_minTunnelMtu;
+    }
+
+    uint64_t GetFragmented() const
+    {
+        return m_fragmented;
+    }
+
+    uint64_t GetFragments() const
+    {
+        return m_fragments;
+    }
+
+    uint64_t GetOversizeDrops() const
+    {
+        return m_oversizeDrops;
+    }
+
+    // Tunnel datagrams the relay's own IP layer fragmented on the way out,
+    // and the fragments it sent for them. Fragmentation by a router further
+    // along the path does not show here.
+    uint64_t GetSentFragmented() const
+    {
+        return m_sentFragmented;
+    }
+
+    uint64_t GetSentFragments() const
+    {
+        return m_sentFragments;
+    }
 
   protected:
     void DoDispose() override;
 
   private:
+    struct Tunnel
+    {
+        ns3::Ipv4Address address;
+        uint16_t port;
+        uint64_t mac;
+        ns3::Time expires;
+        uint32_t mtu;
+        uint32_t pathMtu;
+    };
+
     ns3::Ptr<ns3::Socket> m_recvSocket;
-    ns3::Ptr<ns3::Socket> m_sendSocket;
-    ns3::Ipv4Address m_gatewayAddress;
-    uint16_t m_gatewayPort;
+    ns3::Ptr<ns3::Socket> m_tunnelSocket;
+    ns3::Ptr<ns3::Ipv4L3Protocol> m_ipv4;
+    ns3::Ipv4Address m_relayAddress;
     ns3::Ipv4Address m_multicastGroup;
     uint16_t m_multicastPort;
+    uint16_t m_amtPort;
+    ns3::Time m_tunnelTimeout;
+    uint64_t m_secret;
+    uint32_t m_mtu;
+    bool m_dropOversize;
+    std::function<uint32_t(ns3::Ipv4Address)> m_pathMtu;
+
+    std::vector<Tunnel> m_tunnels;
+
+    uint64_t m_totalPackets;
+    uint64_t m_totalBytes;
+    uint32_t m_peakTunnels;
+    uint32_t m_tunnelSetups;
+    uint32_t m_minTunnelMtu;
+    uint64_t m_fragmented;
+    uint64_t m_fragments;
+    uint64_t m_oversizeDrops;
+    uint64_t m_sentFragmented;
+    uint64_t m_sentFragments;
 
     void StartApplication() override;
     void StopApplication() override;
 
     void HandleRead(ns3::Ptr<ns3::Socket> socket);
+    void HandleControl(ns3::Ptr<ns3::Socket> socket);
+
+    uint64_t ResponseMac(ns3::Ipv4Address address, uint16_t port, uint32_t nonce) const;
+    void AddTunnel(ns3::Ipv4Address address, uint16_t port, uint64_t mac, ns3::Time expires);
+    uint32_t TunnelMtu(ns3::Ipv4Address address);
+
+    void IpTx(ns3::Ptr<const ns3::Packet> packet, ns3::Ptr<ns3::Ipv4> ipv4, uint32_t interface);
 };
 
+// AMT gateway. Decapsulated datagrams are handed to the node's IP layer.
+// Without relays the gateway accepts data from any static tunnel; with
+// SetRelays it discovers a relay among the candidates, keeps the tunnel alive
+// and fails over to another relay when data stalls. Duplicates seen while
+// the new relay catches up after a failover are suppressed per (S,G), using
+// the inner IPv4 identification as a sequence number. That holds only while
+// relays forward the source's datagrams unchanged rather than re-originating
+// them, and the 16 bit identification wraps: anything older than the
+// 1024-entry window passes as new, and a jump larger than the window resets
+// it. Static tunnels and single-relay gateways skip the check. Tunnel datagrams
+// that arrive fragmented are counted at the IP layer, together with those
+// whose reassembly timed out.
 class GatewayApp : public ns3::Application
 {
   public:
@@ -49,18 +188,152 @@ class GatewayApp : public ns3::Application
     ~GatewayApp() override;
 
     void Setup(uint16_t unicastPort);
+    void SetRelays(const std::vector<ns3::Ipv4Address>& relays, uint16_t relayPort);
     void HandleRead(ns3::Ptr<ns3::Socket> socket);
 
+    ns3::Ipv4Address GetRelay() const
+    {
+        return m_relay;
+    }
+
+    uint64_t GetInvalidPackets() const
+    {
+        return m_invalid;
+    }
+
+    uint64_t GetTotalPackets() const
+    {
+        return m_totalPackets;
+    }
+
+    uint64_t GetDuplicates() const
+    {
+        return m_duplicates;
+    }
+
+    uint32_t GetFailovers() const
+    {
+        return m_failovers;
+    }
+
+    ns3::Time GetFailoverTime() const
+    {
+        return m_failoverTime;
+    }
+
+    ns3::Time GetMaxFailoverTime() const
+    {
+        return m_maxFailoverTime;
+    }
+
+    uint64_t GetFragmentsReceived() const
+    {
+        return m_fragmentsReceived;
+    }
+
+    uint64_t GetReassembled() const
+    {
+        return m_reassembled;
+    }
+
+    uint64_t GetReassemblyTimeouts() const
+    {
+        return m_reassemblyTimeouts;
+    }
+
   protected:
     void DoDispose() override;
 
   private:
+    enum class State
+    {
+        Idle,
+        Discovering,
+        Requesting,
+        Joined,
+    };
+
+    struct SequenceWindow
+    {
+        static constexpr uint32_t SIZE = 1024;
+
+        bool initialized = false;
+        uint16_t highest = 0;
+        std::bitset<SIZE> seen;
+
+        bool IsDuplicate(uint16_t id);
+    };
+
     ns3::Ptr<ns3::Socket> m_recvSocket;
-    ns3::Ptr<ns3::Socket> m_sendSocket;
+    ns3::Ptr<ns3::Ipv4L3Protocol> m_ipv4;
     uint16_t m_unicastPort;
 
+    std::vector<ns3::Ipv4Address> m_relays;
+    uint16_t m_relayPort;
+    std::string m_selection;
+    ns3::Time m_discoveryWindow;
+    ns3::Time m_queryInterval;
+    ns3::Time m_stallTimeout;
+    ns3::Ptr<ns3::UniformRandomVariable> m_random;
+
+    State m_state;
+    ns3::Ipv4Address m_relay;
+    std::vector<ns3::Ipv4Address> m_advertised;
+    std::set<ns3::Ipv4Address> m_failed;
+    uint32_t m_discoveryNonce;
+    uint32_t m_requestNonce;
+    uint64_t m_responseMac;
+    ns3::EventId m_discoveryEvent;
+    ns3::EventId m_requestEvent;
+    ns3::EventId m_stallEvent;
+
+    bool m_receiving;
+    bool m_catchingUp;
+    ns3::Time m_lastQuery;
+    ns3::Time m_lastData;
+    ns3::Time m_failoverStart;
+    bool m_failoverPending;
+
+    std::unordered_map<uint64_t, SequenceWindow> m_windows;
+
+    uint64_t m_invalid;
+    uint64_t m_totalPackets;
+    uint64_t m_duplicates;
+    uint32_t m_failovers;
+    ns3::Time m_failoverTime;
+    ns3::Time m_maxFailoverTime;
+    uint64_t m_fragmentsReceived;
+    uint64_t m_reassembled;
+    uint64_t m_reassemblyTimeouts;
+    // Source and identification of datagrams seen in fragments and not yet
+    // reassembled.
+    std::unordered_set<uint64_t> m_fragmentedDatagrams;
+
     void StartApplication() override;
     void StopApplication() override;
+
+    void SendControl(const AmtHeader& header, ns3::Ipv4Address relay);
+
+    void StartDiscovery();
+    void SelectRelay();
+    void SendRequest();
+    void CheckStall();
+    void Failover();
+    ns3::Ipv4Address TunnelAddress(ns3::Ipv4Address relay) const;
+
+    void HandleData(ns3::Ptr<ns3::Packet> packet, ns3::Ipv4Address from, uint32_t recvIf);
+
+    void IpRx(ns3::Ptr<const ns3::Packet> packet, ns3::Ptr<ns3::Ipv4> ipv4, uint32_t interface);
+    void IpLocalDeliver(const ns3::Ipv4Header& header,
+                        ns3::Ptr<const ns3::Packet> packet,
+                        uint32_t interface);
+    void IpDrop(const ns3::Ipv4Header& header,
+                ns3::Ptr<const ns3::Packet> packet,
+                ns3::Ipv4L3Protocol::DropReason reason,
+                ns3::Ptr<ns3::Ipv4> ipv4,
+                uint32_t interface);
+
+    static uint64_t FragmentKey(const ns3::Ipv4Header& header);
 };
 
 class BasicAmt
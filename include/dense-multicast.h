@@ -0,0 +1,10 @@
+#ifndef CAPSTONE_DENSE_MULTICAST_H
+#define CAPSTONE_DENSE_MULTICAST_H
+
+class DenseMulticast
+{
+  public:
+    DenseMulticast(int, char*[]);
+};
+
+#endif
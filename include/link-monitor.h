@@ -0,0 +1,70 @@
+#ifndef CAPSTONE_LINK_MONITOR_H
+#define CAPSTONE_LINK_MONITOR_H
+
+#include "result-store.h"
+
+#include <ns3/data-rate.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/net-device-container.h>
+#include <ns3/nstime.h>
+#include <ns3/packet.h>
+#include <ns3/ptr.h>
+#include <ns3/queue-item.h>
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+struct LinkCounters
+{
+    std::string name;
+    ns3::DataRate rate;
+
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t drops = 0;
+
+    uint64_t multicastPackets = 0;
+    uint64_t multicastBytes = 0;
+    uint64_t amtPackets = 0;
+    uint64_t amtBytes = 0;
+    uint64_t amtDataPackets = 0;
+};
+
+// Per-link byte, packet and drop counters fed by the CSMA device trace
+// sources and the root queue disc of each device, where congestion drops
+// happen. Every frame is counted once, by its sender, when it leaves the
+// wire. Frames are split into native multicast (IPv4 group destination),
+// AMT (UDP to or from a relay/gateway port, including later fragments of the
+// same tunnel) and everything else.
+class LinkMonitor
+{
+  public:
+    void Install(const std::string& link,
+                 const ns3::NetDeviceContainer& devices,
+                 ns3::DataRate rate);
+    void AddAmtPort(uint16_t port);
+
+    const std::map<std::string, LinkCounters>& GetCounters() const
+    {
+        return m_links;
+    }
+
+    void Report(ns3::Time duration) const;
+    void Record(ResultStore& store, ns3::Time duration) const;
+
+  private:
+    std::map<std::string, LinkCounters> m_links;
+    std::set<uint16_t> m_amtPorts;
+    std::set<std::pair<uint32_t, uint32_t>> m_tunnels;
+
+    static void PhyTxEnd(LinkMonitor* monitor, LinkCounters* link, ns3::Ptr<const ns3::Packet> p);
+    static void Drop(LinkCounters* link, ns3::Ptr<const ns3::Packet> p);
+    static void QueueDrop(LinkCounters* link, ns3::Ptr<const ns3::QueueDiscItem> item);
+
+    void Classify(LinkCounters& link, ns3::Ptr<const ns3::Packet> p);
+};
+
+#endif
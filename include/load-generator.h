@@ -0,0 +1,108 @@
+#ifndef CAPSTONE_LOAD_GENERATOR_H
+#define CAPSTONE_LOAD_GENERATOR_H
+
+#include <ns3/application.h>
+#include <ns3/data-rate.h>
+#include <ns3/event-id.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/nstime.h>
+#include <ns3/packet.h>
+#include <ns3/random-variable-stream.h>
+#include <ns3/socket.h>
+#include <ns3/type-id.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Drives N sources x M groups from a single application. Every source owns
+// its own socket (and therefore its own source port) and follows one of the
+// traffic models below at the configured per-source rate:
+//
+//  - poisson: exponential inter-arrival times
+//  - vbr:     frame based video, one I frame per GOP followed by P frames,
+//             each frame's packets paced over FrameSpread of the interval
+//  - onoff:   exponential on/off bursts at a peak rate that keeps the mean
+class LoadGeneratorApp : public ns3::Application
+{
+  public:
+    enum class Model
+    {
+        Poisson,
+        Vbr,
+        OnOff,
+    };
+
+    static ns3::TypeId GetTypeId();
+
+    static Model ParseModel(const std::string& name);
+
+    LoadGeneratorApp();
+    ~LoadGeneratorApp() override;
+
+    void Setup(Model model,
+               const std::vector<ns3::Ipv4Address>& groups,
+               uint16_t port,
+               uint32_t sources,
+               ns3::DataRate rate,
+               uint32_t packetSize);
+
+    uint64_t GetTotalPackets() const
+    {
+        return m_totalPackets;
+    }
+
+    uint64_t GetTotalBytes() const
+    {
+        return m_totalBytes;
+    }
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    struct Flow
+    {
+        ns3::Ptr<ns3::Socket> socket;
+        ns3::EventId event;
+        ns3::EventId pacing;
+        ns3::Time burstEnd;
+        ns3::Time spacing;
+        uint32_t frame;
+        uint32_t remaining;
+    };
+
+    Model m_model;
+    std::vector<ns3::Ipv4Address> m_groups;
+    uint16_t m_port;
+    uint32_t m_sources;
+    ns3::DataRate m_rate;
+    uint32_t m_packetSize;
+
+    double m_frameRate;
+    uint32_t m_gopLength;
+    double m_iFrameRatio;
+    double m_frameSpread;
+    ns3::Time m_onTime;
+    ns3::Time m_offTime;
+
+    std::vector<Flow> m_flows;
+    ns3::Ptr<ns3::UniformRandomVariable> m_uniform;
+    ns3::Ptr<ns3::ExponentialRandomVariable> m_exponential;
+    ns3::Ptr<ns3::NormalRandomVariable> m_normal;
+
+    uint64_t m_totalPackets;
+    uint64_t m_totalBytes;
+
+    void StartApplication() override;
+    void StopApplication() override;
+
+    void Send(Flow& flow, uint32_t count);
+
+    void PoissonTick(uint32_t index);
+    void VbrTick(uint32_t index);
+    void VbrPace(uint32_t index);
+    void OnOffTick(uint32_t index);
+};
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef CAPSTONE_MULTI_RELAY_AMT_H
+#define CAPSTONE_MULTI_RELAY_AMT_H
+
+class MultiRelayAmt
+{
+  public:
+    MultiRelayAmt(int, char*[]);
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef CAPSTONE_MULTICAST_TO_UNICAST_QUEUE_DISC_H
+#define CAPSTONE_MULTICAST_TO_UNICAST_QUEUE_DISC_H
+
+#include <ns3/mac48-address.h>
+#include <ns3/queue-disc.h>
+#include <ns3/type-id.h>
+
+#include <cstdint>
+#include <vector>
+
+// FIFO root queue disc for a Wi-Fi access point that turns every IPv4
+// multicast datagram into one unicast frame per station, the way directed
+// multicast service does on real APs. Copies are made on enqueue and held in
+// the internal queue, so length and drop statistics count each of them;
+// broadcasts are left alone.
+class MulticastToUnicastQueueDisc : public ns3::QueueDisc
+{
+  public:
+    static ns3::TypeId GetTypeId();
+
+    MulticastToUnicastQueueDisc();
+    ~MulticastToUnicastQueueDisc() override;
+
+    void SetStations(const std::vector<ns3::Mac48Address>& stations);
+
+    uint64_t GetConverted() const
+    {
+        return m_converted;
+    }
+
+  private:
+    std::vector<ns3::Mac48Address> m_stations;
+    uint64_t m_converted;
+
+    bool DoEnqueue(ns3::Ptr<ns3::QueueDiscItem> item) override;
+    ns3::Ptr<ns3::QueueDiscItem> DoDequeue() override;
+    bool CheckConfig() override;
+    void InitializeParams() override;
+};
+
+#endif
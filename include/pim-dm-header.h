@@ -0,0 +1,116 @@
+#ifndef CAPSTONE_PIM_DM_HEADER_H
+#define CAPSTONE_PIM_DM_HEADER_H
+
+#include <ns3/buffer.h>
+#include <ns3/header.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/type-id.h>
+
+#include <cstdint>
+#include <ostream>
+
+// PIM-DM message header (RFC 3973, section 4.7). Hello carries only the
+// Holdtime option. Join/Prune, Graft and Graft-Ack carry exactly one group
+// with one source, listed as joined or pruned, which is all the routing
+// protocol ever sends. The checksum field is left zero because the messages
+// travel over UDP, which has its own checksum.
+class PimDmHeader : public ns3::Header
+{
+  public:
+    enum MessageType : uint8_t
+    {
+        HELLO = 0,
+        JOIN_PRUNE = 3,
+        GRAFT = 6,
+        GRAFT_ACK = 7,
+    };
+
+    static constexpr uint8_t VERSION = 2;
+
+    static ns3::TypeId GetTypeId();
+    ns3::TypeId GetInstanceTypeId() const override;
+
+    PimDmHeader();
+    explicit PimDmHeader(MessageType type);
+
+    void Print(std::ostream& os) const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(ns3::Buffer::Iterator start) const override;
+    uint32_t Deserialize(ns3::Buffer::Iterator start) override;
+
+    // False when the last Deserialize saw an unknown version or type, a
+    // truncated message, or a group/source count this model does not send.
+    bool IsValid() const
+    {
+        return m_valid;
+    }
+
+    MessageType GetType() const
+    {
+        return m_type;
+    }
+
+    uint16_t GetHoldTime() const
+    {
+        return m_holdTime;
+    }
+
+    void SetHoldTime(uint16_t seconds)
+    {
+        m_holdTime = seconds;
+    }
+
+    // Router the Join/Prune, Graft or Graft-Ack is addressed to.
+    ns3::Ipv4Address GetUpstream() const
+    {
+        return m_upstream;
+    }
+
+    void SetUpstream(ns3::Ipv4Address upstream)
+    {
+        m_upstream = upstream;
+    }
+
+    ns3::Ipv4Address GetGroup() const
+    {
+        return m_group;
+    }
+
+    void SetGroup(ns3::Ipv4Address group)
+    {
+        m_group = group;
+    }
+
+    ns3::Ipv4Address GetSource() const
+    {
+        return m_source;
+    }
+
+    void SetSource(ns3::Ipv4Address source)
+    {
+        m_source = source;
+    }
+
+    // Whether the source is in the pruned list rather than the joined list.
+    bool IsPrune() const
+    {
+        return m_prune;
+    }
+
+    void SetPrune(bool prune)
+    {
+        m_prune = prune;
+    }
+
+  private:
+    MessageType m_type;
+    bool m_valid;
+
+    uint16_t m_holdTime;
+    ns3::Ipv4Address m_upstream;
+    ns3::Ipv4Address m_group;
+    ns3::Ipv4Address m_source;
+    bool m_prune;
+};
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef CAPSTONE_PIM_DM_ROUTING_H
+#define CAPSTONE_PIM_DM_ROUTING_H
+
+#include "pim-dm-header.h"
+
+#include <ns3/event-id.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/ipv4-header.h>
+#include <ns3/ipv4-interface-address.h>
+#include <ns3/ipv4-route.h>
+#include <ns3/ipv4-routing-protocol.h>
+#include <ns3/ipv4.h>
+#include <ns3/net-device.h>
+#include <ns3/nstime.h>
+#include <ns3/output-stream-wrapper.h>
+#include <ns3/packet.h>
+#include <ns3/ptr.h>
+#include <ns3/random-variable-stream.h>
+#include <ns3/socket.h>
+#include <ns3/type-id.h>
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Dense-mode multicast routing in the style of PIM-DM (RFC 3973), plugged
+// into a node's Ipv4ListRouting above the static and global protocols.
+//
+// Data for an (S,G) is accepted only on the RPF interface, the one unicast
+// routing uses towards S, and flooded to every other interface that has PIM
+// neighbors and is not pruned, or that has group members. A router with
+// nothing downstream prunes itself off the RPF neighbor; prunes expire after
+// PruneHoldTime and the flood starts over. A LAN prune waits OverrideInterval
+// so other downstream routers can override it with a Join. A new member
+// below a pruned router grafts the branch back, retrying until acknowledged.
+//
+// Membership is given by the topology instead of IGMP. Asserts and state
+// refresh are not modelled, so LANs with two upstream routers see duplicates.
+// Control messages are carried over UDP to 224.0.0.13 with TTL 1.
+class PimDmRouting : public ns3::Ipv4RoutingProtocol
+{
+  public:
+    static constexpr uint16_t PIM_PORT = 103;
+
+    struct ControlCounters
+    {
+        uint64_t hellos = 0;
+        uint64_t joins = 0;
+        uint64_t prunes = 0;
+        uint64_t grafts = 0;
+        uint64_t graftAcks = 0;
+        uint64_t bytes = 0;
+    };
+
+    static ns3::TypeId GetTypeId();
+
+    PimDmRouting();
+    ~PimDmRouting() override;
+
+    ns3::Ptr<ns3::Ipv4Route> RouteOutput(ns3::Ptr<ns3::Packet> p,
+                                         const ns3::Ipv4Header& header,
+                                         ns3::Ptr<ns3::NetDevice> oif,
+                                         ns3::Socket::SocketErrno& sockerr) override;
+    bool RouteInput(ns3::Ptr<const ns3::Packet> p,
+                    const ns3::Ipv4Header& header,
+                    ns3::Ptr<const ns3::NetDevice> idev,
+                    const UnicastForwardCallback& ucb,
+                    const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb,
+                    const ErrorCallback& ecb) override;
+    void NotifyInterfaceUp(uint32_t interface) override;
+    void NotifyInterfaceDown(uint32_t interface) override;
+    void NotifyAddAddress(uint32_t interface, ns3::Ipv4InterfaceAddress address) override;
+    void NotifyRemoveAddress(uint32_t interface, ns3::Ipv4InterfaceAddress address) override;
+    void SetIpv4(ns3::Ptr<ns3::Ipv4> ipv4) override;
+    void PrintRoutingTable(ns3::Ptr<ns3::OutputStreamWrapper> stream,
+                           ns3::Time::Unit unit = ns3::Time::S) const override;
+
+    // Group members on an attached link, counted so several hosts on one
+    // link can join and leave independently.
+    void AddMembership(uint32_t interface, ns3::Ipv4Address group);
+    void RemoveMembership(uint32_t interface, ns3::Ipv4Address group);
+
+    // Group members on the router itself.
+    void AddLocalMembership(ns3::Ipv4Address group);
+    void RemoveLocalMembership(ns3::Ipv4Address group);
+
+    const ControlCounters& GetSent() const
+    {
+        return m_sent;
+    }
+
+    uint64_t GetReceived() const
+    {
+        return m_received;
+    }
+
+    uint64_t GetForwarded() const
+    {
+        return m_forwarded;
+    }
+
+    uint64_t GetRpfFailures() const
+    {
+        return m_rpfFailures;
+    }
+
+    // Joins sent to override a Prune overheard on a multi-access link.
+    uint64_t GetPruneOverrides() const
+    {
+        return m_pruneOverrides;
+    }
+
+    uint32_t GetNeighbors() const;
+
+    uint32_t GetEntries() const
+    {
+        return m_entries.size();
+    }
+
+    // Downstream interfaces currently forwarding or pruned, summed over all
+    // (S,G) entries.
+    uint32_t GetForwardingInterfaces() const;
+    uint32_t GetPrunedInterfaces() const;
+
+  protected:
+    void DoInitialize() override;
+    void DoDispose() override;
+
+  private:
+    using Key = std::pair<ns3::Ipv4Address, ns3::Ipv4Address>;
+
+    struct Entry
+    {
+        ns3::Ipv4Address source;
+        ns3::Ipv4Address group;
+        uint32_t iif = 0;
+        // RPF neighbor, or the source itself when it is on the RPF link.
+        ns3::Ipv4Address upstream;
+
+        std::map<uint32_t, ns3::Time> prunedUntil;
+        std::map<uint32_t, ns3::EventId> pendingPrunes;
+        std::map<uint32_t, ns3::Time> nonRpfPruneLimit;
+
+        bool upstreamPruned = false;
+        ns3::Time pruneLimit;
+        bool graftPending = false;
+        ns3::EventId graftRetry;
+    };
+
+    ns3::Ptr<ns3::Ipv4> m_ipv4;
+    ns3::Ptr<ns3::Socket> m_recvSocket;
+    std::map<uint32_t, ns3::Ptr<ns3::Socket>> m_sockets;
+    bool m_initialized;
+
+    ns3::Time m_helloInterval;
+    ns3::Time m_triggeredHelloDelay;
+    ns3::Time m_pruneHoldTime;
+    ns3::Time m_pruneLimitInterval;
+    ns3::Time m_overrideInterval;
+    ns3::Time m_graftRetryInterval;
+    ns3::Ptr<ns3::UniformRandomVariable> m_random;
+    ns3::EventId m_helloEvent;
+
+    // Interface -> neighbor address -> expiry.
+    std::map<uint32_t, std::map<ns3::Ipv4Address, ns3::Time>> m_neighbors;
+    std::map<std::pair<uint32_t, ns3::Ipv4Address>, uint32_t> m_members;
+    std::map<ns3::Ipv4Address, uint32_t> m_localMembers;
+    std::map<Key, Entry> m_entries;
+
+    ControlCounters m_sent;
+    uint64_t m_received;
+    uint64_t m_forwarded;
+    uint64_t m_rpfFailures;
+    uint64_t m_pruneOverrides;
+
+    void CreateSocket(uint32_t interface);
+    void SendHellos();
+    void Send(uint32_t interface, const PimDmHeader& header);
+    void SendJoinPrune(uint32_t interface,
+                       ns3::Ipv4Address upstream,
+                       const Entry& entry,
+                       bool prune);
+    void Receive(ns3::Ptr<ns3::Socket> socket);
+
+    void HandleJoinPrune(uint32_t interface, ns3::Ipv4Address from, const PimDmHeader& header);
+    void HandleGraft(uint32_t interface, ns3::Ipv4Address from, const PimDmHeader& header);
+    void ApplyPrune(Key key, uint32_t interface, ns3::Time holdTime);
+
+    Entry* GetEntry(ns3::Ipv4Address source, ns3::Ipv4Address group);
+    bool IsNeighbor(uint32_t interface, ns3::Ipv4Address address) const;
+    uint32_t NeighborCount(uint32_t interface) const;
+    bool IsLocalAddress(uint32_t interface, ns3::Ipv4Address address) const;
+    std::vector<uint32_t> OutgoingInterfaces(const Entry& entry) const;
+    bool WantsTraffic(const Entry& entry) const;
+
+    void PruneUpstream(Entry& entry);
+    void Graft(Entry& entry);
+    void RetryGraft(Key key);
+    void MembershipAdded(ns3::Ipv4Address group);
+};
+
+#endif
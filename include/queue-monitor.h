@@ -0,0 +1,67 @@
+#ifndef CAPSTONE_QUEUE_MONITOR_H
+#define CAPSTONE_QUEUE_MONITOR_H
+
+#include "result-store.h"
+
+#include <ns3/nstime.h>
+#include <ns3/ptr.h>
+#include <ns3/queue-disc.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+struct QueueSample
+{
+    double time;
+    uint32_t packets;
+    uint32_t bytes;
+    double sojournMean;
+    double sojournMax;
+};
+
+// Samples queue disc depth at a fixed interval. Sojourn times reported by
+// the queue disc between two samples are folded into a running mean and
+// maximum, so the cost per dequeued packet is a few additions.
+class QueueMonitor
+{
+  public:
+    void Install(const std::string& label, ns3::Ptr<ns3::QueueDisc> disc, ns3::Time interval);
+
+    void Report() const;
+    void Write(const std::string& filename) const;
+    void Record(ResultStore& store) const;
+
+  private:
+    struct Series
+    {
+        ns3::Ptr<ns3::QueueDisc> disc;
+        ns3::Time interval;
+        std::vector<QueueSample> samples;
+
+        double sojournSum = 0;
+        double sojournMax = 0;
+        uint32_t sojournCount = 0;
+
+        double totalSojourn = 0;
+        uint64_t totalDequeued = 0;
+    };
+
+    struct Summary
+    {
+        double depthMean;
+        uint32_t depthMax;
+        double sojournMean;
+        double sojournMax;
+    };
+
+    std::map<std::string, Series> m_series;
+
+    static Summary Summarize(const Series& series);
+
+    static void Sojourn(Series* series, ns3::Time sojourn);
+    static void Sample(Series* series);
+};
+
+#endif
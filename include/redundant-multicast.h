@@ -0,0 +1,10 @@
+#ifndef CAPSTONE_REDUNDANT_MULTICAST_H
+#define CAPSTONE_REDUNDANT_MULTICAST_H
+
+class RedundantMulticast
+{
+  public:
+    RedundantMulticast(int, char*[]);
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef CAPSTONE_RESULT_STORE_H
+#define CAPSTONE_RESULT_STORE_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct sqlite3;
+
+// Collects one run's configuration, parameters, metrics and timings in
+// memory and writes them to a SQLite database in a single transaction when
+// the run is committed. Several sweep processes may share one database;
+// SQLite's write lock serializes their commits.
+//
+// Schema:
+//   runs(id, config, config_hash, started, wall_seconds, sim_seconds)
+//   parameters(run_id, key, value)            flattened YAML, dotted keys
+//   metrics(run_id, kind, entity, metric, value)
+//   timings(run_id, phase, seconds)
+class ResultStore
+{
+  public:
+    ResultStore() = default;
+    ~ResultStore();
+
+    ResultStore(const ResultStore&) = delete;
+    ResultStore& operator=(const ResultStore&) = delete;
+
+    void Open(const std::string& path);
+
+    bool IsOpen() const
+    {
+        return m_db != nullptr;
+    }
+
+    void BeginRun(const std::string& config, const std::string& text);
+    void AddParameter(const std::string& key, const std::string& value);
+    void AddMetric(const std::string& kind,
+                   const std::string& entity,
+                   const std::string& metric,
+                   double value);
+    void AddTiming(const std::string& phase, double seconds);
+    void Commit(double wallSeconds, double simSeconds);
+
+    static uint64_t Hash(const std::string& text);
+
+  private:
+    struct Metric
+    {
+        std::string kind;
+        std::string entity;
+        std::string metric;
+        double value;
+    };
+
+    sqlite3* m_db = nullptr;
+
+    std::string m_config;
+    std::string m_configHash;
+    std::string m_started;
+    std::vector<std::pair<std::string, std::string>> m_parameters;
+    std::vector<Metric> m_metrics;
+    std::vector<std::pair<std::string, double>> m_timings;
+
+    void Execute(const char* sql);
+};
+
+#endif
@@ -1,16 +1,34 @@
 #ifndef INCLUDE_SETUP_H
 #define INCLUDE_SETUP_H
 
+#include "basic-amt.h"
+#include "link-monitor.h"
+#include "load-generator.h"
+#include "pim-dm-routing.h"
+#include "queue-monitor.h"
+#include "result-store.h"
+#include "trace-replay.h"
+#include "wifi-monitor.h"
+
+#include <ns3/address.h>
 #include <ns3/ipv4-address.h>
 #include <ns3/ipv4-interface-container.h>
 #include <ns3/net-device-container.h>
 #include <ns3/node-container.h>
 #include <ns3/node.h>
+#include <ns3/nstime.h>
+#include <ns3/packet.h>
+#include <ns3/packet-sink.h>
 #include <ns3/ptr.h>
 
+#include <chrono>
 #include <cstdint>
+#include <map>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+#include <yaml-cpp/node/node.h>
 
 struct Link
 {
@@ -43,9 +61,28 @@ struct AppConfig
     std::string gateway;
     uint16_t unicast;
     std::string link;
+    uint32_t mtu = 0;
+    bool dropOversize = false;
 
     // For Gateway
     std::string relay;
+    std::vector<std::string> relays;
+    std::string selection;
+    double stall = 0.5;
+
+    // For TraceReplay
+    std::string trace;
+    bool loop = false;
+
+    // For LoadGen
+    std::string model;
+    uint32_t sources = 1;
+    std::vector<std::string> groups;
+    double fps = 30.0;
+    uint32_t gop = 12;
+    double spread = 1.0;
+    double onTime = 0.5;
+    double offTime = 0.5;
 };
 
 class Topology
@@ -73,6 +110,11 @@ class Topology
         return m_mcGroup;
     }
 
+    const std::vector<std::string>& GetMcGroups() const
+    {
+        return m_mcGroups;
+    }
+
     const std::vector<McRoute>& GetMcRoutes() const
     {
         return m_mcRoutes;
@@ -83,6 +125,10 @@ class Topology
         return m_apps;
     }
 
+    // Prints every report and, when the configuration names a results
+    // database, commits the run to it.
+    void Report();
+
   private:
     ns3::NodeContainer m_nodes;
     std::unordered_map<std::string, ns3::Ptr<ns3::Node>> m_nodeMap;
@@ -90,14 +136,47 @@ class Topology
 
     std::string m_mcSource;
     std::string m_mcGroup;
+    std::vector<std::string> m_mcGroups;
+    std::string m_mcProtocol;
+    ns3::Ipv4Address m_mcSourceAddress;
     std::vector<McRoute> m_mcRoutes;
 
     std::vector<AppConfig> m_apps;
+    std::vector<std::pair<std::string, ns3::Ptr<RelayApp>>> m_relayApps;
+    std::vector<std::pair<std::string, ns3::Ptr<GatewayApp>>> m_gatewayApps;
+    std::vector<std::pair<std::string, ns3::Ptr<TraceReplayApp>>> m_replayApps;
+    std::vector<std::pair<std::string, ns3::Ptr<LoadGeneratorApp>>> m_loadApps;
+    std::vector<std::pair<std::string, ns3::Ptr<ns3::PacketSink>>> m_sinkApps;
+    std::map<std::string, ns3::Time> m_sinkFirstRx;
+    std::map<std::string, ns3::Ptr<PimDmRouting>> m_pimRouters;
+
+    LinkMonitor m_linkMonitor;
+    QueueMonitor m_queueMonitor;
+    WifiMonitor m_wifiMonitor;
+    std::string m_queueLog;
 
     std::string m_pcap;
 
+    ResultStore m_results;
+    std::chrono::steady_clock::time_point m_wallStart;
+    std::chrono::steady_clock::time_point m_setupEnd;
+
     uint32_t FindInterfaceIndex(ns3::Ptr<ns3::Node>, const std::string&);
     ns3::Ipv4Address GetAddressOnLink(ns3::Ptr<ns3::Node>, const std::string&);
+    ns3::Ipv4Address GetNodeAddress(ns3::Ptr<ns3::Node>);
+    ns3::Ptr<ns3::Node> FindNodeByAddress(ns3::Ipv4Address) const;
+    uint32_t PathMtu(ns3::Ptr<ns3::Node>, ns3::Ipv4Address) const;
+    void InstallPimDm();
+    void ScheduleMembership(ns3::Ptr<ns3::Node>, const std::vector<std::string>&, double, double);
+    double GetJoinLatency(const std::string&) const;
+
+    static void SinkRx(std::map<std::string, ns3::Time>* firstRx,
+                       std::string node,
+                       ns3::Ptr<const ns3::Packet>,
+                       const ns3::Address&);
+    ns3::NetDeviceContainer InstallWifi(const YAML::Node&,
+                                        const std::string&,
+                                        const ns3::NodeContainer&);
 };
 
 #endif
@@ -0,0 +1,128 @@
+#ifndef CAPSTONE_TRACE_REPLAY_H
+#define CAPSTONE_TRACE_REPLAY_H
+
+#include <ns3/application.h>
+#include <ns3/event-id.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/nstime.h>
+#include <ns3/socket.h>
+#include <ns3/type-id.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct TraceRecord
+{
+    ns3::Time gap;
+    uint32_t size;
+};
+
+// Streams packet records out of a memory-mapped trace file. Two formats are
+// detected from the leading magic number:
+//
+//  - libpcap (microsecond or nanosecond timestamps, either byte order); the
+//    link, IPv4 and UDP header bytes implied by the link type are subtracted
+//    from the original length so that the replayed payload matches the wire.
+//  - compact trace: the little-endian magic "TRC1" followed by 8 byte records
+//    of { uint32 gap in microseconds, uint32 payload size }, as written by
+//    the trace-gen tool.
+//
+// Pages that have been consumed are released back to the kernel, so the
+// resident size stays bounded for multi-gigabyte captures.
+class TraceReader
+{
+  public:
+    TraceReader();
+    ~TraceReader();
+
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    void Open(const std::string& path);
+    void Close();
+    void Rewind();
+
+    bool Next(TraceRecord& record);
+
+    // Pcap timestamps give no gap for the first record; compact traces store
+    // one.
+    bool IsPcap() const
+    {
+        return m_format == Format::Pcap;
+    }
+
+  private:
+    enum class Format
+    {
+        Pcap,
+        Compact,
+    };
+
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_offset;
+    size_t m_released;
+    size_t m_begin;
+
+    Format m_format;
+    bool m_bigEndian;
+    bool m_nanoseconds;
+    uint32_t m_overhead;
+    int64_t m_lastTimestamp;
+
+    uint32_t Read32(size_t offset) const;
+    void Release();
+};
+
+class TraceReplayApp : public ns3::Application
+{
+  public:
+    static ns3::TypeId GetTypeId();
+
+    TraceReplayApp();
+    ~TraceReplayApp() override;
+
+    void Setup(const std::string& traceFile, ns3::Ipv4Address group, uint16_t port);
+
+    uint64_t GetTotalPackets() const
+    {
+        return m_totalPackets;
+    }
+
+    uint64_t GetTotalBytes() const
+    {
+        return m_totalBytes;
+    }
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    ns3::Ptr<ns3::Socket> m_socket;
+    std::string m_traceFile;
+    ns3::Ipv4Address m_group;
+    uint16_t m_port;
+    bool m_loop;
+
+    TraceReader m_reader;
+    ns3::EventId m_sendEvent;
+    uint32_t m_pendingSize;
+
+    // Span from the first to the last record of the first pass and its
+    // record count, for the wrap-around gap of pcap traces.
+    bool m_wrapped;
+    ns3::Time m_passTime;
+    uint64_t m_passRecords;
+
+    uint64_t m_totalPackets;
+    uint64_t m_totalBytes;
+
+    void StartApplication() override;
+    void StopApplication() override;
+
+    void ScheduleNext();
+    void SendPacket();
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef CAPSTONE_WIFI_MONITOR_H
+#define CAPSTONE_WIFI_MONITOR_H
+
+#include "result-store.h"
+
+#include <ns3/mac48-address.h>
+#include <ns3/nstime.h>
+#include <ns3/packet.h>
+#include <ns3/ptr.h>
+#include <ns3/wifi-net-device.h>
+#include <ns3/wifi-phy-state.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Per-station throughput and airtime on Wi-Fi access segments. Throughput
+// is what each station's MAC hands up the stack. Airtime is the time the
+// AP's radio spends transmitting: the PHY state trace gives the duration and
+// the PhyTxBegin trace fired at the same instant gives the receiver address.
+// Unicast data airtime belongs to its station; group addressed data airtime
+// is spent once and shared by every station on the segment.
+class WifiMonitor
+{
+  public:
+    void Install(const std::string& link,
+                 ns3::Ptr<ns3::WifiNetDevice> ap,
+                 const std::vector<std::pair<std::string, ns3::Ptr<ns3::WifiNetDevice>>>& stations);
+
+    void Report(ns3::Time duration) const;
+    void Record(ResultStore& store) const;
+
+  private:
+    struct Station
+    {
+        std::string node;
+        ns3::Mac48Address address;
+
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+        ns3::Time firstRx;
+        ns3::Time lastRx;
+
+        ns3::Time airtime;
+
+        double Throughput() const;
+    };
+
+    struct Segment
+    {
+        std::vector<Station> stations;
+
+        ns3::Time multicastAirtime;
+        ns3::Time unicastAirtime;
+        ns3::Time otherAirtime;
+
+        // The two AP traces fire back to back for one transmission; whichever
+        // comes first waits here for its partner.
+        bool pendingFrame = false;
+        ns3::Time frameAt;
+        ns3::Mac48Address frameReceiver;
+        bool frameData = false;
+
+        bool pendingTx = false;
+        ns3::Time txAt;
+        ns3::Time txDuration;
+    };
+
+    std::map<std::string, Segment> m_segments;
+
+    static void MacRx(Station* station, ns3::Ptr<const ns3::Packet> p);
+    static void PhyTxBegin(Segment* segment, ns3::Ptr<const ns3::Packet> p, double txPowerW);
+    static void PhyState(Segment* segment,
+                         ns3::Time start,
+                         ns3::Time duration,
+                         ns3::WifiPhyState state);
+    static void Account(Segment& segment,
+                        ns3::Mac48Address receiver,
+                        bool data,
+                        ns3::Time duration);
+};
+
+#endif
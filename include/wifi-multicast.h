@@ -0,0 +1,10 @@
+#ifndef CAPSTONE_WIFI_MULTICAST_H
+#define CAPSTONE_WIFI_MULTICAST_H
+
+class WifiMulticast
+{
+  public:
+    WifiMulticast(int, char*[]);
+};
+
+#endif
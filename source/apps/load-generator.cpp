@@ -0,0 +1,302 @@
+#include "load-generator.h"
+
+#include <ns3/application.h>
+#include <ns3/double.h>
+#include <ns3/fatal-error.h>
+#include <ns3/inet-socket-address.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/nstime.h>
+#include <ns3/packet.h>
+#include <ns3/ptr.h>
+#include <ns3/simulator.h>
+#include <ns3/socket.h>
+#include <ns3/type-id.h>
+#include <ns3/uinteger.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+NS_OBJECT_ENSURE_REGISTERED(LoadGeneratorApp);
+
+TypeId
+LoadGeneratorApp::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("LoadGeneratorApp")
+            .SetParent<Application>()
+            .SetGroupName("Applications")
+            .AddConstructor<LoadGeneratorApp>()
+            .AddAttribute("FrameRate",
+                          "Frames per second of the vbr model",
+                          DoubleValue(30.0),
+                          MakeDoubleAccessor(&LoadGeneratorApp::m_frameRate),
+                          MakeDoubleChecker<double>(1.0))
+            .AddAttribute("GopLength",
+                          "Frames per group of pictures of the vbr model",
+                          UintegerValue(12),
+                          MakeUintegerAccessor(&LoadGeneratorApp::m_gopLength),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("IFrameRatio",
+                          "Size of an I frame relative to a P frame in the vbr model",
+                          DoubleValue(4.0),
+                          MakeDoubleAccessor(&LoadGeneratorApp::m_iFrameRatio),
+                          MakeDoubleChecker<double>(1.0))
+            .AddAttribute("FrameSpread",
+                          "Share of the frame interval a vbr frame's packets are paced over; "
+                          "0 sends each frame as one burst",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&LoadGeneratorApp::m_frameSpread),
+                          MakeDoubleChecker<double>(0.0, 1.0))
+            .AddAttribute("OnTime",
+                          "Mean burst length of the onoff model",
+                          TimeValue(MilliSeconds(500)),
+                          MakeTimeAccessor(&LoadGeneratorApp::m_onTime),
+                          MakeTimeChecker())
+            .AddAttribute("OffTime",
+                          "Mean silence length of the onoff model",
+                          TimeValue(MilliSeconds(500)),
+                          MakeTimeAccessor(&LoadGeneratorApp::m_offTime),
+                          MakeTimeChecker());
+    return tid;
+}
+
+LoadGeneratorApp::Model
+LoadGeneratorApp::ParseModel(const std::string& name)
+{
+    if (name == "poisson")
+    {
+        return Model::Poisson;
+    }
+    if (name == "vbr")
+    {
+        return Model::Vbr;
+    }
+    if (name == "onoff")
+    {
+        return Model::OnOff;
+    }
+    NS_FATAL_ERROR("Unknown load generator model: " << name);
+    return Model::Poisson;
+}
+
+LoadGeneratorApp::LoadGeneratorApp()
+    : m_model(Model::Poisson),
+      m_port(0),
+      m_sources(1),
+      m_packetSize(1024),
+      m_frameRate(30.0),
+      m_gopLength(12),
+      m_iFrameRatio(4.0),
+      m_frameSpread(1.0),
+      m_uniform(CreateObject<UniformRandomVariable>()),
+      m_exponential(CreateObject<ExponentialRandomVariable>()),
+      m_normal(CreateObject<NormalRandomVariable>()),
+      m_totalPackets(0),
+      m_totalBytes(0)
+{
+}
+
+LoadGeneratorApp::~LoadGeneratorApp()
+{
+}
+
+void
+LoadGeneratorApp::Setup(Model model,
+                        const std::vector<Ipv4Address>& groups,
+                        uint16_t port,
+                        uint32_t sources,
+                        DataRate rate,
+                        uint32_t packetSize)
+{
+    m_model = model;
+    m_groups = groups;
+    m_port = port;
+    m_sources = std::max<uint32_t>(sources, 1);
+    m_rate = rate;
+    m_packetSize = packetSize;
+
+    if (m_model == Model::OnOff && (m_onTime + m_offTime).IsZero())
+    {
+        NS_FATAL_ERROR("Load generator onoff model needs a non-zero OnTime or OffTime");
+    }
+}
+
+void
+LoadGeneratorApp::DoDispose()
+{
+    m_flows.clear();
+    Application::DoDispose();
+}
+
+void
+LoadGeneratorApp::StartApplication()
+{
+    if (m_groups.empty())
+    {
+        NS_FATAL_ERROR("Load generator has no target group");
+    }
+
+    m_flows.resize(m_groups.size() * m_sources);
+
+    auto id = TypeId::LookupByName("ns3::UdpSocketFactory");
+    double packetTime = m_rate.CalculateBytesTxTime(m_packetSize).GetSeconds();
+    double frameTime = 1.0 / m_frameRate;
+
+    for (uint32_t i = 0; i < m_flows.size(); ++i)
+    {
+        Flow& flow = m_flows[i];
+        if (!flow.socket)
+        {
+            flow.socket = Socket::CreateSocket(GetNode(), id);
+            if (flow.socket->Bind() == -1)
+            {
+                NS_FATAL_ERROR("Failed to bind load generator socket");
+            }
+            flow.socket->Connect(InetSocketAddress(m_groups[i / m_sources], m_port));
+            flow.socket->SetAllowBroadcast(true);
+            flow.socket->ShutdownRecv();
+        }
+        flow.frame = 0;
+        flow.remaining = 0;
+
+        // Stagger the sources so they do not fire in lockstep.
+        switch (m_model)
+        {
+        case Model::Poisson:
+            flow.event = Simulator::Schedule(Seconds(m_uniform->GetValue(0, packetTime)),
+                                             &LoadGeneratorApp::PoissonTick,
+                                             this,
+                                             i);
+            break;
+        case Model::Vbr:
+            flow.event = Simulator::Schedule(Seconds(m_uniform->GetValue(0, frameTime)),
+                                             &LoadGeneratorApp::VbrTick,
+                                             this,
+                                             i);
+            break;
+        case Model::OnOff:
+            flow.burstEnd =
+                Simulator::Now() + Seconds(m_exponential->GetValue(m_onTime.GetSeconds(), 0));
+            flow.event = Simulator::Schedule(Seconds(m_uniform->GetValue(0, packetTime)),
+                                             &LoadGeneratorApp::OnOffTick,
+                                             this,
+                                             i);
+            break;
+        }
+    }
+}
+
+void
+LoadGeneratorApp::StopApplication()
+{
+    for (auto& flow : m_flows)
+    {
+        Simulator::Cancel(flow.event);
+        Simulator::Cancel(flow.pacing);
+        if (flow.socket)
+        {
+            flow.socket->Close();
+        }
+    }
+}
+
+void
+LoadGeneratorApp::Send(Flow& flow, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (flow.socket->Send(Create<Packet>(m_packetSize)) < 0)
+        {
+            return;
+        }
+        ++m_totalPackets;
+        m_totalBytes += m_packetSize;
+    }
+}
+
+void
+LoadGeneratorApp::PoissonTick(uint32_t index)
+{
+    Flow& flow = m_flows[index];
+    Send(flow, 1);
+
+    double mean = m_rate.CalculateBytesTxTime(m_packetSize).GetSeconds();
+    flow.event = Simulator::Schedule(Seconds(m_exponential->GetValue(mean, 0)),
+                                     &LoadGeneratorApp::PoissonTick,
+                                     this,
+                                     index);
+}
+
+void
+LoadGeneratorApp::VbrTick(uint32_t index)
+{
+    Flow& flow = m_flows[index];
+
+    // Scale P frames so that one GOP averages out to the configured rate.
+    double meanFrame = m_rate.GetBitRate() / 8.0 / m_frameRate;
+    double pFrame = meanFrame * m_gopLength / (m_gopLength - 1 + m_iFrameRatio);
+    double frame = (flow.frame % m_gopLength == 0) ? pFrame * m_iFrameRatio : pFrame;
+    frame *= std::max(m_normal->GetValue(1.0, 0.01, 0.5), 0.1);
+    ++flow.frame;
+
+    auto count = static_cast<uint32_t>(std::max(std::lround(frame / m_packetSize), 1L));
+
+    // Whatever is left of the previous frame goes out before this one.
+    Simulator::Cancel(flow.pacing);
+    Send(flow, flow.remaining);
+    flow.remaining = 0;
+
+    if (m_frameSpread > 0 && count > 1)
+    {
+        flow.spacing = Seconds(m_frameSpread / m_frameRate / count);
+        flow.remaining = count;
+        VbrPace(index);
+    }
+    else
+    {
+        Send(flow, count);
+    }
+
+    flow.event = Simulator::Schedule(Seconds(1.0 / m_frameRate),
+                                     &LoadGeneratorApp::VbrTick,
+                                     this,
+                                     index);
+}
+
+void
+LoadGeneratorApp::VbrPace(uint32_t index)
+{
+    Flow& flow = m_flows[index];
+    Send(flow, 1);
+    if (--flow.remaining > 0)
+    {
+        flow.pacing = Simulator::Schedule(flow.spacing, &LoadGeneratorApp::VbrPace, this, index);
+    }
+}
+
+void
+LoadGeneratorApp::OnOffTick(uint32_t index)
+{
+    Flow& flow = m_flows[index];
+
+    if (Simulator::Now() >= flow.burstEnd)
+    {
+        Time off = Seconds(m_exponential->GetValue(m_offTime.GetSeconds(), 0));
+        Time on = Seconds(m_exponential->GetValue(m_onTime.GetSeconds(), 0));
+        flow.burstEnd = Simulator::Now() + off + on;
+        flow.event = Simulator::Schedule(off, &LoadGeneratorApp::OnOffTick, this, index);
+        return;
+    }
+
+    Send(flow, 1);
+
+    // Bursts run at the peak rate that yields the configured mean rate.
+    double duty = m_onTime.GetSeconds() / (m_onTime + m_offTime).GetSeconds();
+    double gap = m_rate.CalculateBytesTxTime(m_packetSize).GetSeconds() * duty;
+    flow.event = Simulator::Schedule(Seconds(gap), &LoadGeneratorApp::OnOffTick, this, index);
+}
@@ -0,0 +1,387 @@
+#include "trace-replay.h"
+
+#include <ns3/application.h>
+#include <ns3/boolean.h>
+#include <ns3/fatal-error.h>
+#include <ns3/inet-socket-address.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/nstime.h>
+#include <ns3/packet.h>
+#include <ns3/ptr.h>
+#include <ns3/simulator.h>
+#include <ns3/socket.h>
+#include <ns3/type-id.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_OBJECT_ENSURE_REGISTERED(TraceReplayApp);
+
+namespace
+{
+
+constexpr size_t PCAP_GLOBAL_HEADER = 24;
+constexpr size_t PCAP_RECORD_HEADER = 16;
+constexpr size_t COMPACT_HEADER = 4;
+constexpr size_t COMPACT_RECORD = 8;
+constexpr uint32_t COMPACT_MAGIC = 0x31435254; // "TRC1"
+constexpr uint32_t MAX_UDP_PAYLOAD = 65507;
+constexpr size_t RELEASE_CHUNK = 16 * 1024 * 1024;
+
+uint32_t
+LinkOverhead(uint32_t linkType)
+{
+    constexpr uint32_t ipv4Udp = 20 + 8;
+    switch (linkType)
+    {
+    case 0: // BSD loopback
+        return 4 + ipv4Udp;
+    case 1: // Ethernet
+        return 14 + ipv4Udp;
+    case 101: // raw IP
+    case 228: // raw IPv4
+        return ipv4Udp;
+    case 113: // Linux cooked capture
+        return 16 + ipv4Udp;
+    case 276: // Linux cooked capture v2
+        return 20 + ipv4Udp;
+    default:
+        return 0;
+    }
+}
+
+} // namespace
+
+TraceReader::TraceReader()
+    : m_data(nullptr),
+      m_size(0),
+      m_offset(0),
+      m_released(0),
+      m_begin(0),
+      m_format(Format::Compact),
+      m_bigEndian(false),
+      m_nanoseconds(false),
+      m_overhead(0),
+      m_lastTimestamp(-1)
+{
+}
+
+TraceReader::~TraceReader()
+{
+    Close();
+}
+
+void
+TraceReader::Open(const std::string& path)
+{
+    Close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        NS_FATAL_ERROR("Failed to open trace file: " << path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) == -1 || st.st_size < static_cast<off_t>(COMPACT_HEADER))
+    {
+        ::close(fd);
+        NS_FATAL_ERROR("Trace file is empty or unreadable: " << path);
+    }
+
+    void* mapped = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        NS_FATAL_ERROR("Failed to mmap trace file: " << path);
+    }
+    ::madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+
+    m_data = static_cast<const uint8_t*>(mapped);
+    m_size = static_cast<size_t>(st.st_size);
+
+    const uint8_t* m = m_data;
+    if (m[0] == 0xd4 && m[1] == 0xc3 && m[2] == 0xb2 && m[3] == 0xa1)
+    {
+        m_format = Format::Pcap;
+        m_bigEndian = false;
+        m_nanoseconds = false;
+    }
+    else if (m[0] == 0xa1 && m[1] == 0xb2 && m[2] == 0xc3 && m[3] == 0xd4)
+    {
+        m_format = Format::Pcap;
+        m_bigEndian = true;
+        m_nanoseconds = false;
+    }
+    else if (m[0] == 0x4d && m[1] == 0x3c && m[2] == 0xb2 && m[3] == 0xa1)
+    {
+        m_format = Format::Pcap;
+        m_bigEndian = false;
+        m_nanoseconds = true;
+    }
+    else if (m[0] == 0xa1 && m[1] == 0xb2 && m[2] == 0x3c && m[3] == 0x4d)
+    {
+        m_format = Format::Pcap;
+        m_bigEndian = true;
+        m_nanoseconds = true;
+    }
+    else
+    {
+        m_format = Format::Compact;
+        m_bigEndian = false;
+        if (Read32(0) != COMPACT_MAGIC)
+        {
+            Close();
+            NS_FATAL_ERROR("Unknown trace file format: " << path);
+        }
+    }
+
+    if (m_format == Format::Pcap)
+    {
+        if (m_size < PCAP_GLOBAL_HEADER)
+        {
+            Close();
+            NS_FATAL_ERROR("Truncated pcap header: " << path);
+        }
+        m_overhead = LinkOverhead(Read32(20));
+        m_begin = PCAP_GLOBAL_HEADER;
+    }
+    else
+    {
+        m_overhead = 0;
+        m_begin = COMPACT_HEADER;
+    }
+
+    Rewind();
+}
+
+void
+TraceReader::Close()
+{
+    if (m_data)
+    {
+        ::munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_offset = 0;
+    m_released = 0;
+}
+
+void
+TraceReader::Rewind()
+{
+    m_offset = m_begin;
+    m_released = 0;
+    m_lastTimestamp = -1;
+}
+
+bool
+TraceReader::Next(TraceRecord& record)
+{
+    if (!m_data)
+    {
+        return false;
+    }
+
+    if (m_format == Format::Compact)
+    {
+        if (m_offset + COMPACT_RECORD > m_size)
+        {
+            return false;
+        }
+        record.gap = MicroSeconds(Read32(m_offset));
+        record.size = Read32(m_offset + 4);
+        m_offset += COMPACT_RECORD;
+    }
+    else
+    {
+        if (m_offset + PCAP_RECORD_HEADER > m_size)
+        {
+            return false;
+        }
+        int64_t seconds = Read32(m_offset);
+        int64_t fraction = Read32(m_offset + 4);
+        uint32_t captured = Read32(m_offset + 8);
+        uint32_t original = Read32(m_offset + 12);
+
+        if (m_offset + PCAP_RECORD_HEADER + captured > m_size)
+        {
+            return false;
+        }
+        m_offset += PCAP_RECORD_HEADER + captured;
+
+        int64_t timestamp = seconds * 1000000000 + fraction * (m_nanoseconds ? 1 : 1000);
+        int64_t gap = m_lastTimestamp < 0 ? 0 : std::max<int64_t>(timestamp - m_lastTimestamp, 0);
+        m_lastTimestamp = timestamp;
+
+        record.gap = NanoSeconds(gap);
+        record.size = original > m_overhead ? original - m_overhead : 1;
+    }
+
+    record.size = std::clamp<uint32_t>(record.size, 1, MAX_UDP_PAYLOAD);
+    Release();
+    return true;
+}
+
+uint32_t
+TraceReader::Read32(size_t offset) const
+{
+    const uint8_t* p = m_data + offset;
+    if (m_bigEndian)
+    {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) |
+               uint32_t(p[3]);
+    }
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+           (uint32_t(p[3]) << 24);
+}
+
+void
+TraceReader::Release()
+{
+    while (m_offset - m_released >= 2 * RELEASE_CHUNK)
+    {
+        ::madvise(const_cast<uint8_t*>(m_data) + m_released, RELEASE_CHUNK, MADV_DONTNEED);
+        m_released += RELEASE_CHUNK;
+    }
+}
+
+TypeId
+TraceReplayApp::GetTypeId()
+{
+    static TypeId tid = TypeId("TraceReplayApp")
+                            .SetParent<Application>()
+                            .SetGroupName("Applications")
+                            .AddConstructor<TraceReplayApp>()
+                            .AddAttribute("Loop",
+                                          "Restart from the first record when the trace ends",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&TraceReplayApp::m_loop),
+                                          MakeBooleanChecker());
+    return tid;
+}
+
+TraceReplayApp::TraceReplayApp()
+    : m_socket(nullptr),
+      m_port(0),
+      m_loop(false),
+      m_pendingSize(0),
+      m_wrapped(false),
+      m_passRecords(0),
+      m_totalPackets(0),
+      m_totalBytes(0)
+{
+}
+
+TraceReplayApp::~TraceReplayApp()
+{
+}
+
+void
+TraceReplayApp::Setup(const std::string& traceFile, Ipv4Address group, uint16_t port)
+{
+    m_traceFile = traceFile;
+    m_group = group;
+    m_port = port;
+}
+
+void
+TraceReplayApp::DoDispose()
+{
+    m_socket = nullptr;
+    m_reader.Close();
+    Application::DoDispose();
+}
+
+void
+TraceReplayApp::StartApplication()
+{
+    if (!m_socket)
+    {
+        auto id = TypeId::LookupByName("ns3::UdpSocketFactory");
+        m_socket = Socket::CreateSocket(GetNode(), id);
+        if (m_socket->Bind() == -1)
+        {
+            NS_FATAL_ERROR("Failed to bind trace replay socket");
+        }
+        m_socket->Connect(InetSocketAddress(m_group, m_port));
+        m_socket->SetAllowBroadcast(true);
+        m_socket->ShutdownRecv();
+    }
+
+    m_reader.Open(m_traceFile);
+    m_wrapped = false;
+    m_passTime = Time(0);
+    m_passRecords = 0;
+    ScheduleNext();
+}
+
+void
+TraceReplayApp::StopApplication()
+{
+    Simulator::Cancel(m_sendEvent);
+    if (m_socket)
+    {
+        m_socket->Close();
+    }
+    m_reader.Close();
+}
+
+void
+TraceReplayApp::ScheduleNext()
+{
+    TraceRecord record;
+    if (m_reader.Next(record))
+    {
+        if (!m_wrapped)
+        {
+            // The first gap is an offset from the start, not a spacing.
+            if (m_passRecords > 0)
+            {
+                m_passTime += record.gap;
+            }
+            ++m_passRecords;
+        }
+    }
+    else
+    {
+        if (!m_loop)
+        {
+            return;
+        }
+        m_reader.Rewind();
+        if (!m_reader.Next(record))
+        {
+            return;
+        }
+        // A pcap's first record has no predecessor to measure a gap from,
+        // so wrap around after the trace's mean gap instead of bursting.
+        m_wrapped = true;
+        if (m_reader.IsPcap() && m_passRecords > 1)
+        {
+            record.gap = NanoSeconds(m_passTime.GetNanoSeconds() / (m_passRecords - 1));
+        }
+    }
+
+    m_pendingSize = record.size;
+    m_sendEvent = Simulator::Schedule(record.gap, &TraceReplayApp::SendPacket, this);
+}
+
+void
+TraceReplayApp::SendPacket()
+{
+    if (m_socket->Send(Create<Packet>(m_pendingSize)) >= 0)
+    {
+        ++m_totalPackets;
+        m_totalBytes += m_pendingSize;
+    }
+    ScheduleNext();
+}
@@ -1,5 +1,9 @@
 #include "basic-amt.h"
 #include "basic-multicast.h"
+#include "dense-multicast.h"
+#include "multi-relay-amt.h"
+#include "redundant-multicast.h"
+#include "wifi-multicast.h"
 
 int
 main(int argc, char* argv[])
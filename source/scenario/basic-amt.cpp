@@ -1,5 +1,6 @@
 #include "basic-amt.h"
 
+#include "amt-header.h"
 #include "setup.h"
 
 #include <ns3/application.h>
@@ -9,15 +10,30 @@
 #include <ns3/inet-socket-address.h>
 #include <ns3/ipv4-address.h>
 #include <ns3/ipv4-header.h>
+#include <ns3/ipv4-l3-protocol.h>
+#include <ns3/ipv4-packet-info-tag.h>
+#include <ns3/ipv4-route.h>
+#include <ns3/ipv4-routing-protocol.h>
+#include <ns3/ipv4.h>
+#include <ns3/net-device.h>
+#include <ns3/node.h>
+#include <ns3/nstime.h>
+#include <ns3/packet.h>
 #include <ns3/ptr.h>
+#include <ns3/random-variable-stream.h>
 #include <ns3/simulator.h>
 #include <ns3/socket.h>
+#include <ns3/string.h>
 #include <ns3/type-id.h>
-#include <ns3/udp-header.h>
 #include <ns3/udp-socket.h>
 #include <ns3/uinteger.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -30,15 +46,48 @@ RelayApp::GetTypeId()
     static TypeId id = TypeId("RelayApp")
                            .SetParent<Application>()
                            .SetGroupName("Applications")
-                           .AddConstructor<RelayApp>();
+                           .AddConstructor<RelayApp>()
+                           .AddAttribute("Port",
+                                         "UDP port of the relay's AMT endpoint",
+                                         UintegerValue(2268),
+                                         MakeUintegerAccessor(&RelayApp::m_amtPort),
+                                         MakeUintegerChecker<uint16_t>())
+                           .AddAttribute("TunnelTimeout",
+                                         "Lifetime of a dynamic tunnel without membership updates",
+                                         TimeValue(Seconds(3)),
+                                         MakeTimeAccessor(&RelayApp::m_tunnelTimeout),
+                                         MakeTimeChecker())
+                           .AddAttribute("Mtu",
+                                         "Tunnel MTU; 0 looks up the path MTU per gateway",
+                                         UintegerValue(0),
+                                         MakeUintegerAccessor(&RelayApp::m_mtu),
+                                         MakeUintegerChecker<uint32_t>())
+                           .AddAttribute("DropOversize",
+                                         "Drop datagrams that would be fragmented on the tunnel",
+                                         BooleanValue(false),
+                                         MakeBooleanAccessor(&RelayApp::m_dropOversize),
+                                         MakeBooleanChecker());
     return id;
 }
 
 RelayApp::RelayApp()
     : m_recvSocket(nullptr),
-      m_sendSocket(nullptr),
-      m_gatewayPort(0),
-      m_multicastPort(0)
+      m_tunnelSocket(nullptr),
+      m_multicastPort(0),
+      m_amtPort(2268),
+      m_secret(0),
+      m_mtu(0),
+      m_dropOversize(false),
+      m_totalPackets(0),
+      m_totalBytes(0),
+      m_peakTunnels(0),
+      m_tunnelSetups(0),
+      m_minTunnelMtu(0),
+      m_fragmented(0),
+      m_fragments(0),
+      m_oversizeDrops(0),
+      m_sentFragmented(0),
+      m_sentFragments(0)
 {
 }
 
@@ -48,12 +97,29 @@ RelayApp::Setup(Ipv4Address gatewayAddress,
                 Ipv4Address multicastGroup,
                 uint16_t multicastPort)
 {
-    m_gatewayAddress = gatewayAddress;
-    m_gatewayPort = gatewayPort;
+    AddTunnel(gatewayAddress, gatewayPort, 0, Time::Max());
+    Setup(multicastGroup, multicastPort);
+}
+
+void
+RelayApp::Setup(Ipv4Address multicastGroup, uint16_t multicastPort)
+{
     m_multicastGroup = multicastGroup;
     m_multicastPort = multicastPort;
 }
 
+void
+RelayApp::SetRelayAddress(Ipv4Address relayAddress)
+{
+    m_relayAddress = relayAddress;
+}
+
+void
+RelayApp::SetPathMtuCallback(std::function<uint32_t(Ipv4Address)> pathMtu)
+{
+    m_pathMtu = std::move(pathMtu);
+}
+
 RelayApp::~RelayApp()
 {
 }
@@ -62,7 +128,8 @@ void
 RelayApp::DoDispose()
 {
     m_recvSocket = nullptr;
-    m_sendSocket = nullptr;
+    m_tunnelSocket = nullptr;
+    m_ipv4 = nullptr;
     Application::DoDispose();
 }
 
@@ -82,11 +149,25 @@ RelayApp::StartApplication()
     }
     m_recvSocket->SetRecvCallback(MakeCallback(&RelayApp::HandleRead, this));
 
-    if (!m_sendSocket)
+    if (!m_tunnelSocket)
     {
         auto id = TypeId::LookupByName("ns3::UdpSocketFactory");
-        m_sendSocket = Socket::CreateSocket(GetNode(), id);
+        m_tunnelSocket = Socket::CreateSocket(GetNode(), id);
+        auto local = InetSocketAddress(Ipv4Address::GetAny(), m_amtPort);
+        if (m_tunnelSocket->Bind(local) == -1)
+        {
+            NS_FATAL_ERROR("Failed to bind AMT relay socket");
+        }
     }
+    m_tunnelSocket->SetRecvCallback(MakeCallback(&RelayApp::HandleControl, this));
+
+    if (!m_ipv4)
+    {
+        m_ipv4 = GetNode()->GetObject<Ipv4L3Protocol>();
+        m_ipv4->TraceConnectWithoutContext("Tx", MakeCallback(&RelayApp::IpTx, this));
+    }
+
+    m_secret = CreateObject<UniformRandomVariable>()->GetInteger(1, UINT32_MAX);
 }
 
 void
@@ -97,10 +178,12 @@ RelayApp::StopApplication()
         m_recvSocket->Close();
         m_recvSocket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
     }
-    if (m_sendSocket)
+    if (m_tunnelSocket)
     {
-        m_sendSocket->Close();
+        m_tunnelSocket->Close();
+        m_tunnelSocket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
     }
+    m_tunnels.clear();
 }
 
 void
@@ -112,32 +195,254 @@ RelayApp::HandleRead(Ptr<Socket> socket)
     {
         Ipv4Header ipv4Header;
         packet->PeekHeader(ipv4Header);
-        if (ipv4Header.GetDestination() == m_multicastGroup)
+        if (ipv4Header.GetDestination() != m_multicastGroup)
+        {
+            continue;
+        }
+
+        Time now = Simulator::Now();
+        std::erase_if(m_tunnels, [now](const Tunnel& t) { return t.expires < now; });
+        if (m_tunnels.empty())
+        {
+            continue;
+        }
+
+        packet->AddHeader(AmtHeader(AmtHeader::MULTICAST_DATA));
+        // Outer IPv4 and UDP headers come on top of the AMT data header.
+        uint32_t outerSize = packet->GetSize() + 8 + 20;
+        for (size_t i = 0; i < m_tunnels.size(); ++i)
+        {
+            Tunnel& tunnel = m_tunnels[i];
+            if (tunnel.pathMtu == 0)
+            {
+                tunnel.pathMtu = TunnelMtu(tunnel.address);
+                tunnel.mtu = tunnel.mtu ? tunnel.mtu : tunnel.pathMtu;
+                m_minTunnelMtu = m_minTunnelMtu ? std::min(m_minTunnelMtu, tunnel.mtu) : tunnel.mtu;
+            }
+            bool oversize = outerSize > tunnel.mtu;
+            if (oversize && m_dropOversize)
+            {
+                ++m_oversizeDrops;
+                continue;
+            }
+
+            // The received packet goes to the last tunnel; earlier ones get
+            // copies taken before it is handed to the socket.
+            Ptr<Packet> out = (i + 1 == m_tunnels.size()) ? packet : packet->Copy();
+            uint32_t size = out->GetSize();
+            auto to = InetSocketAddress(tunnel.address, tunnel.port);
+            if (m_tunnelSocket->SendTo(out, 0, to) >= 0)
+            {
+                ++m_totalPackets;
+                m_totalBytes += size;
+                // Whichever hop has the smallest MTU does the fragmenting.
+                if (outerSize > tunnel.pathMtu)
+                {
+                    // Every fragment but the last carries a multiple of 8 bytes.
+                    uint32_t perFragment = (tunnel.pathMtu - 20) & ~7U;
+                    ++m_fragmented;
+                    m_fragments += (outerSize - 20 + perFragment - 1) / perFragment;
+                }
+            }
+        }
+    }
+}
+
+void
+RelayApp::HandleControl(Ptr<Socket> socket)
+{
+    Ptr<Packet> packet;
+    Address from;
+    while ((packet = socket->RecvFrom(from)))
+    {
+        auto source = InetSocketAddress::ConvertFrom(from);
+
+        AmtHeader request;
+        packet->RemoveHeader(request);
+        if (!request.IsValid())
         {
-            uint8_t header[4] = {0x06, 0x00, 0x00, 0x00};
-            auto encapsulatedPacket = Create<Packet>(header, 4);
-            encapsulatedPacket->AddAtEnd(packet);
+            continue;
+        }
 
-            m_sendSocket->SendTo(encapsulatedPacket,
-                                 0,
-                                 InetSocketAddress(m_gatewayAddress, m_gatewayPort));
+        // Encapsulated IGMP/MLD messages are not modelled: a valid membership
+        // update joins the gateway to the relay's group.
+        switch (request.GetType())
+        {
+        case AmtHeader::RELAY_DISCOVERY: {
+            AmtHeader advertisement(AmtHeader::RELAY_ADVERTISEMENT);
+            advertisement.SetNonce(request.GetNonce());
+            advertisement.SetRelayAddress(m_relayAddress);
+            auto reply = Create<Packet>();
+            reply->AddHeader(advertisement);
+            socket->SendTo(reply, 0, from);
+            break;
+        }
+        case AmtHeader::REQUEST: {
+            AmtHeader query(AmtHeader::MEMBERSHIP_QUERY);
+            query.SetNonce(request.GetNonce());
+            query.SetResponseMac(
+                ResponseMac(source.GetIpv4(), source.GetPort(), request.GetNonce()));
+            auto reply = Create<Packet>();
+            reply->AddHeader(query);
+            socket->SendTo(reply, 0, from);
+            break;
+        }
+        case AmtHeader::MEMBERSHIP_UPDATE: {
+            uint64_t mac = ResponseMac(source.GetIpv4(), source.GetPort(), request.GetNonce());
+            if (request.GetResponseMac() == mac)
+            {
+                AddTunnel(source.GetIpv4(),
+                          source.GetPort(),
+                          mac,
+                          Simulator::Now() + m_tunnelTimeout);
+            }
+            break;
+        }
+        case AmtHeader::TEARDOWN: {
+            uint64_t mac = request.GetResponseMac();
+            std::erase_if(m_tunnels, [mac](const Tunnel& t) { return t.mac != 0 && t.mac == mac; });
+            break;
+        }
+        default:
+            break;
         }
     }
 }
 
+uint64_t
+RelayApp::ResponseMac(Ipv4Address address, uint16_t port, uint32_t nonce) const
+{
+    // FNV-1a over the relay secret and the gateway's address, port and nonce.
+    uint64_t hash = 0xcbf29ce484222325;
+    auto mix = [&hash](uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i)
+        {
+            hash ^= (value >> (8 * i)) & 0xff;
+            hash *= 0x100000001b3;
+        }
+    };
+    mix(m_secret, 8);
+    mix(address.Get(), 4);
+    mix(port, 2);
+    mix(nonce, 4);
+    return (hash & 0xffffffffffff) | 1;
+}
+
+void
+RelayApp::AddTunnel(Ipv4Address address, uint16_t port, uint64_t mac, Time expires)
+{
+    for (auto& t : m_tunnels)
+    {
+        if (t.address == address && t.port == port)
+        {
+            t.mac = mac;
+            t.expires = expires;
+            return;
+        }
+    }
+
+    m_tunnels.push_back(Tunnel{address, port, mac, expires, m_mtu, 0});
+    m_peakTunnels = std::max<uint32_t>(m_peakTunnels, m_tunnels.size());
+    ++m_tunnelSetups;
+}
+
+void
+RelayApp::IpTx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+    // Fragments as IP actually emits them on the egress device, whatever MTU
+    // the tunnel was configured with.
+    Ipv4Header header;
+    packet->PeekHeader(header);
+    if (header.GetProtocol() != 17 || header.GetDestination().IsMulticast() ||
+        m_ipv4->GetInterfaceForAddress(header.GetSource()) < 0)
+    {
+        return;
+    }
+    if (!header.IsLastFragment() || header.GetFragmentOffset() != 0)
+    {
+        ++m_sentFragments;
+        if (header.GetFragmentOffset() == 0)
+        {
+            ++m_sentFragmented;
+        }
+    }
+}
+
+uint32_t
+RelayApp::TunnelMtu(Ipv4Address address)
+{
+    if (m_pathMtu)
+    {
+        if (uint32_t mtu = m_pathMtu(address))
+        {
+            return mtu;
+        }
+    }
+
+    Ipv4Header header;
+    header.SetDestination(address);
+    Socket::SocketErrno error;
+    auto ipv4 = GetNode()->GetObject<Ipv4>();
+    Ptr<Ipv4Route> route = ipv4->GetRoutingProtocol()->RouteOutput(nullptr, header, nullptr, error);
+    if (!route)
+    {
+        NS_FATAL_ERROR("No route from relay to gateway " << address);
+    }
+    return route->GetOutputDevice()->GetMtu();
+}
+
 TypeId
 GatewayApp::GetTypeId()
 {
-    static TypeId tid = TypeId("GatewayApp")
-                            .SetParent<Application>()
-                            .SetGroupName("Applications")
-                            .AddConstructor<GatewayApp>();
+    static TypeId tid =
+        TypeId("GatewayApp")
+            .SetParent<Application>()
+            .SetGroupName("Applications")
+            .AddConstructor<GatewayApp>()
+            .AddAttribute("Selection",
+                          "Relay choice among advertisements: nearest or hash",
+                          StringValue("nearest"),
+                          MakeStringAccessor(&GatewayApp::m_selection),
+                          MakeStringChecker())
+            .AddAttribute("DiscoveryWindow",
+                          "Time to collect relay advertisements",
+                          TimeValue(MilliSeconds(20)),
+                          MakeTimeAccessor(&GatewayApp::m_discoveryWindow),
+                          MakeTimeChecker())
+            .AddAttribute("QueryInterval",
+                          "Interval of the request/query/update keepalive",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&GatewayApp::m_queryInterval),
+                          MakeTimeChecker())
+            .AddAttribute("StallTimeout",
+                          "Silence on the tunnel after which the gateway fails over",
+                          TimeValue(MilliSeconds(500)),
+                          MakeTimeAccessor(&GatewayApp::m_stallTimeout),
+                          MakeTimeChecker());
     return tid;
 }
 
 GatewayApp::GatewayApp()
     : m_recvSocket(nullptr),
-      m_sendSocket(nullptr)
+      m_ipv4(nullptr),
+      m_unicastPort(0),
+      m_relayPort(2268),
+      m_selection("nearest"),
+      m_random(CreateObject<UniformRandomVariable>()),
+      m_state(State::Idle),
+      m_discoveryNonce(0),
+      m_requestNonce(0),
+      m_responseMac(0),
+      m_receiving(false),
+      m_catchingUp(false),
+      m_failoverPending(false),
+      m_invalid(0),
+      m_totalPackets(0),
+      m_duplicates(0),
+      m_failovers(0),
+      m_fragmentsReceived(0),
+      m_reassembled(0),
+      m_reassemblyTimeouts(0)
 {
 }
 
@@ -149,7 +454,8 @@ void
 GatewayApp::DoDispose()
 {
     m_recvSocket = nullptr;
-    m_sendSocket = nullptr;
+    m_ipv4 = nullptr;
+    m_random = nullptr;
     Application::DoDispose();
 }
 
@@ -159,6 +465,13 @@ GatewayApp::Setup(uint16_t unicastPort)
     m_unicastPort = unicastPort;
 }
 
+void
+GatewayApp::SetRelays(const std::vector<Ipv4Address>& relays, uint16_t relayPort)
+{
+    m_relays = relays;
+    m_relayPort = relayPort;
+}
+
 void
 GatewayApp::StartApplication()
 {
@@ -171,28 +484,47 @@ GatewayApp::StartApplication()
         {
             NS_FATAL_ERROR("Failed to bind unicast socket");
         }
+        m_recvSocket->SetRecvPktInfo(true);
     }
     m_recvSocket->SetRecvCallback(MakeCallback(&GatewayApp::HandleRead, this));
 
-    if (!m_sendSocket)
+    if (!m_ipv4)
     {
-        TypeId id = TypeId::LookupByName("ns3::UdpSocketFactory");
-        m_sendSocket = Socket::CreateSocket(GetNode(), id);
+        m_ipv4 = GetNode()->GetObject<Ipv4L3Protocol>();
+        m_ipv4->TraceConnectWithoutContext("Rx", MakeCallback(&GatewayApp::IpRx, this));
+        m_ipv4->TraceConnectWithoutContext("LocalDeliver",
+                                           MakeCallback(&GatewayApp::IpLocalDeliver, this));
+        m_ipv4->TraceConnectWithoutContext("Drop", MakeCallback(&GatewayApp::IpDrop, this));
+    }
+
+    if (!m_relays.empty())
+    {
+        StartDiscovery();
     }
 }
 
 void
 GatewayApp::StopApplication()
 {
+    Simulator::Cancel(m_discoveryEvent);
+    Simulator::Cancel(m_requestEvent);
+    Simulator::Cancel(m_stallEvent);
+
     if (m_recvSocket)
     {
+        if (m_state == State::Joined)
+        {
+            AmtHeader teardown(AmtHeader::TEARDOWN);
+            teardown.SetResponseMac(m_responseMac);
+            teardown.SetNonce(m_requestNonce);
+            teardown.SetGatewayPort(m_unicastPort);
+            teardown.SetGatewayAddress(TunnelAddress(m_relay));
+            SendControl(teardown, m_relay);
+        }
         m_recvSocket->Close();
         m_recvSocket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
     }
-    if (m_sendSocket)
-    {
-        m_sendSocket->Close();
-    }
+    m_state = State::Idle;
 }
 
 void
@@ -202,19 +534,360 @@ GatewayApp::HandleRead(Ptr<Socket> socket)
     Address from;
     while ((packet = socket->RecvFrom(from)))
     {
-        packet->RemoveAtStart(4);
+        Ipv4PacketInfoTag info;
+        if (!packet->RemovePacketTag(info))
+        {
+            continue;
+        }
+        packet->RemoveAllPacketTags();
+        Ipv4Address source = InetSocketAddress::ConvertFrom(from).GetIpv4();
 
-        Ipv4Header ipv4Header;
-        packet->RemoveHeader(ipv4Header);
+        AmtHeader amtHeader;
+        packet->RemoveHeader(amtHeader);
+        if (!amtHeader.IsValid())
+        {
+            ++m_invalid;
+            continue;
+        }
+
+        switch (amtHeader.GetType())
+        {
+        case AmtHeader::MULTICAST_DATA:
+            HandleData(packet, source, info.GetRecvIf());
+            break;
+        case AmtHeader::RELAY_ADVERTISEMENT:
+            if (m_state == State::Discovering && amtHeader.GetNonce() == m_discoveryNonce)
+            {
+                // Advertisements arrive in order of distance, which is what an
+                // anycast discovery address would deliver to.
+                m_advertised.push_back(amtHeader.GetRelayAddress());
+                if (m_selection == "nearest")
+                {
+                    Simulator::Cancel(m_discoveryEvent);
+                    SelectRelay();
+                }
+            }
+            break;
+        case AmtHeader::MEMBERSHIP_QUERY:
+            if (m_state != State::Discovering && source == m_relay &&
+                amtHeader.GetNonce() == m_requestNonce)
+            {
+                m_lastQuery = Simulator::Now();
+                m_responseMac = amtHeader.GetResponseMac();
+                AmtHeader update(AmtHeader::MEMBERSHIP_UPDATE);
+                update.SetResponseMac(m_responseMac);
+                update.SetNonce(m_requestNonce);
+                SendControl(update, m_relay);
+                m_state = State::Joined;
+            }
+            break;
+        default:
+            ++m_invalid;
+            break;
+        }
+    }
+}
+
+void
+GatewayApp::HandleData(Ptr<Packet> packet, Ipv4Address from, uint32_t recvIf)
+{
+    Ipv4Header ipv4Header;
+    packet->PeekHeader(ipv4Header);
+    Ipv4Address multicastGroup = ipv4Header.GetDestination();
+    if (!multicastGroup.IsMulticast())
+    {
+        ++m_invalid;
+        return;
+    }
+
+    if (!m_relays.empty() && from == m_relay)
+    {
+        m_receiving = true;
+        m_lastData = Simulator::Now();
+        if (m_failoverPending)
+        {
+            Time outage = m_lastData - m_failoverStart;
+            m_failoverTime += outage;
+            m_maxFailoverTime = std::max(m_maxFailoverTime, outage);
+            m_failoverPending = false;
+        }
+        if (m_stallEvent.IsExpired())
+        {
+            m_stallEvent = Simulator::Schedule(m_stallTimeout, &GatewayApp::CheckStall, this);
+        }
+    }
+
+    // With one relay, or a static tunnel, there is nothing to overlap. With
+    // several the window keeps recording, but only drops packets between a
+    // failover and the first datagram the new relay delivers that was not
+    // already seen.
+    if (m_relays.size() > 1)
+    {
+        uint64_t key = (uint64_t(ipv4Header.GetSource().Get()) << 32) | multicastGroup.Get();
+        bool duplicate = m_windows[key].IsDuplicate(ipv4Header.GetIdentification());
+        if (m_catchingUp && duplicate)
+        {
+            ++m_duplicates;
+            return;
+        }
+        if (m_catchingUp && from == m_relay)
+        {
+            m_catchingUp = false;
+        }
+    }
+
+    // Hand the inner datagram to IP as if it had arrived on the tunnel
+    // interface, so (S,G) routes, RPF and TTL handling see the original
+    // source instead of a locally originated copy.
+    Ptr<NetDevice> device = GetNode()->GetDevice(recvIf);
+    m_ipv4->Receive(device,
+                    packet,
+                    Ipv4L3Protocol::PROT_NUMBER,
+                    device->GetAddress(),
+                    device->GetMulticast(multicastGroup),
+                    NetDevice::PACKET_MULTICAST);
+    ++m_totalPackets;
+}
+
+void
+GatewayApp::IpRx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+    Ipv4Header header;
+    packet->PeekHeader(header);
+    if (header.GetDestination().IsMulticast() || header.GetProtocol() != 17)
+    {
+        return;
+    }
+    if (!header.IsLastFragment() || header.GetFragmentOffset() != 0)
+    {
+        ++m_fragmentsReceived;
+        m_fragmentedDatagrams.insert(FragmentKey(header));
+    }
+}
+
+void
+GatewayApp::IpLocalDeliver(const Ipv4Header& header, Ptr<const Packet> packet, uint32_t interface)
+{
+    // IP clears the fragment fields once a datagram is reassembled, so match
+    // on the source and identification its fragments arrived with.
+    if (header.GetProtocol() == 17 && m_fragmentedDatagrams.erase(FragmentKey(header)))
+    {
+        ++m_reassembled;
+    }
+}
 
-        UdpHeader udpHeader;
-        packet->RemoveHeader(udpHeader);
+void
+GatewayApp::IpDrop(const Ipv4Header& header,
+                   Ptr<const Packet> packet,
+                   Ipv4L3Protocol::DropReason reason,
+                   Ptr<Ipv4> ipv4,
+                   uint32_t interface)
+{
+    if (reason == Ipv4L3Protocol::DROP_FRAGMENT_TIMEOUT && header.GetProtocol() == 17)
+    {
+        ++m_reassemblyTimeouts;
+        m_fragmentedDatagrams.erase(FragmentKey(header));
+    }
+}
+
+uint64_t
+GatewayApp::FragmentKey(const Ipv4Header& header)
+{
+    return (uint64_t(header.GetSource().Get()) << 16) | header.GetIdentification();
+}
 
-        Ipv4Address multicastGroup = ipv4Header.GetDestination();
-        uint16_t multicastPort = udpHeader.GetDestinationPort();
+void
+GatewayApp::SendControl(const AmtHeader& header, Ipv4Address relay)
+{
+    auto packet = Create<Packet>();
+    packet->AddHeader(header);
+    m_recvSocket->SendTo(packet, 0, InetSocketAddress(relay, m_relayPort));
+}
+
+void
+GatewayApp::StartDiscovery()
+{
+    m_state = State::Discovering;
+    m_advertised.clear();
+    m_discoveryNonce = m_random->GetInteger(1, UINT32_MAX);
 
-        m_sendSocket->SendTo(packet, 0, InetSocketAddress(multicastGroup, multicastPort));
+    AmtHeader discovery(AmtHeader::RELAY_DISCOVERY);
+    discovery.SetNonce(m_discoveryNonce);
+
+    if (std::all_of(m_relays.begin(), m_relays.end(), [this](const Ipv4Address& r) {
+            return m_failed.count(r) > 0;
+        }))
+    {
+        m_failed.clear();
+    }
+    for (auto& relay : m_relays)
+    {
+        if (!m_failed.count(relay))
+        {
+            SendControl(discovery, relay);
+        }
+    }
+
+    m_discoveryEvent = Simulator::Schedule(m_discoveryWindow, &GatewayApp::SelectRelay, this);
+}
+
+void
+GatewayApp::SelectRelay()
+{
+    if (m_advertised.empty())
+    {
+        m_discoveryEvent = Simulator::Schedule(m_queryInterval, &GatewayApp::StartDiscovery, this);
+        return;
+    }
+
+    Ipv4Address relay = m_advertised.front();
+    if (m_selection == "hash")
+    {
+        // Spread gateways over the responding relays by node identity.
+        std::sort(m_advertised.begin(), m_advertised.end());
+        relay = m_advertised[(GetNode()->GetId() * 2654435761U) % m_advertised.size()];
+    }
+
+    m_relay = relay;
+    m_state = State::Requesting;
+    Simulator::Cancel(m_requestEvent);
+    SendRequest();
+
+    // Judge the new relay from its first Request on, so one that never
+    // answers or never delivers is abandoned as well.
+    m_receiving = false;
+    m_lastQuery = Simulator::Now();
+    m_lastData = Simulator::Now();
+    Simulator::Cancel(m_stallEvent);
+    m_stallEvent = Simulator::Schedule(m_stallTimeout, &GatewayApp::CheckStall, this);
+}
+
+void
+GatewayApp::SendRequest()
+{
+    m_requestNonce = m_random->GetInteger(1, UINT32_MAX);
+    AmtHeader request(AmtHeader::REQUEST);
+    request.SetNonce(m_requestNonce);
+    SendControl(request, m_relay);
+
+    m_requestEvent = Simulator::Schedule(m_queryInterval, &GatewayApp::SendRequest, this);
+}
+
+void
+GatewayApp::CheckStall()
+{
+    if (!m_receiving)
+    {
+        // Before data flows the source may simply not have started; only a
+        // relay that stops answering Requests, one per query interval, has
+        // failed.
+        Time silent = Simulator::Now() - m_lastQuery;
+        Time limit = m_queryInterval + m_stallTimeout;
+        if (silent >= limit || (m_state != State::Joined && silent >= m_stallTimeout))
+        {
+            Failover();
+            return;
+        }
+        m_stallEvent = Simulator::Schedule(m_stallTimeout, &GatewayApp::CheckStall, this);
+        return;
+    }
+
+    Time idle = Simulator::Now() - m_lastData;
+    if (idle >= m_stallTimeout)
+    {
+        Failover();
+        return;
+    }
+    m_stallEvent = Simulator::Schedule(m_stallTimeout - idle, &GatewayApp::CheckStall, this);
+}
+
+void
+GatewayApp::Failover()
+{
+    ++m_failovers;
+    if (!m_failoverPending)
+    {
+        m_failoverStart = m_lastData;
+        m_failoverPending = true;
+    }
+
+    if (m_state == State::Joined)
+    {
+        AmtHeader teardown(AmtHeader::TEARDOWN);
+        teardown.SetResponseMac(m_responseMac);
+        teardown.SetNonce(m_requestNonce);
+        teardown.SetGatewayPort(m_unicastPort);
+        teardown.SetGatewayAddress(TunnelAddress(m_relay));
+        SendControl(teardown, m_relay);
+    }
+
+    m_failed.insert(m_relay);
+    m_receiving = false;
+    m_catchingUp = true;
+    Simulator::Cancel(m_requestEvent);
+    Simulator::Cancel(m_discoveryEvent);
+    Simulator::Cancel(m_stallEvent);
+    StartDiscovery();
+}
+
+Ipv4Address
+GatewayApp::TunnelAddress(Ipv4Address relay) const
+{
+    // The source address the Request went out with, which is the one the
+    // relay built the tunnel for.
+    Ipv4Header header;
+    header.SetDestination(relay);
+    Socket::SocketErrno error;
+    Ptr<Ipv4Route> route =
+        m_ipv4->GetRoutingProtocol()->RouteOutput(nullptr, header, nullptr, error);
+    if (!route)
+    {
+        NS_FATAL_ERROR("No route from gateway to relay " << relay);
+    }
+    return route->GetSource();
+}
+
+bool
+GatewayApp::SequenceWindow::IsDuplicate(uint16_t id)
+{
+    if (!initialized)
+    {
+        initialized = true;
+        highest = id;
+        seen.set(id % SIZE);
+        return false;
+    }
+
+    auto delta = static_cast<int16_t>(static_cast<uint16_t>(id - highest));
+    if (delta > 0)
+    {
+        if (delta >= static_cast<int32_t>(SIZE))
+        {
+            seen.reset();
+        }
+        else
+        {
+            for (int32_t i = 1; i <= delta; ++i)
+            {
+                seen.reset(static_cast<uint16_t>(highest + i) % SIZE);
+            }
+        }
+        highest = id;
+        seen.set(id % SIZE);
+        return false;
+    }
+
+    if (-delta >= static_cast<int32_t>(SIZE))
+    {
+        // Older than the window; let it through rather than guess.
+        return false;
+    }
+    if (seen.test(id % SIZE))
+    {
+        return true;
     }
+    seen.set(id % SIZE);
+    return false;
 }
 
 BasicAmt::BasicAmt(int argc, char* argv[])
@@ -227,5 +900,6 @@ BasicAmt::BasicAmt(int argc, char* argv[])
 
     Simulator::Stop(Seconds(21.0));
     Simulator::Run();
+    topology.Report();
     Simulator::Destroy();
 }
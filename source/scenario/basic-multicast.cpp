@@ -15,5 +15,6 @@ BasicMulticast::BasicMulticast(int argc, char* argv[])
 
     Simulator::Stop(Seconds(21.0));
     Simulator::Run();
+    topology.Report();
     Simulator::Destroy();
 }
@@ -0,0 +1,19 @@
+#include "dense-multicast.h"
+
+#include "setup.h"
+
+#include <ns3/simulator.h>
+
+DenseMulticast::DenseMulticast(int argc, char* argv[])
+{
+    using namespace ns3;
+    std::string filename{"../resources/dense-multicast.yaml"};
+
+    std::cout << "topology setup: " << filename << std::endl;
+    Topology topology(filename);
+
+    Simulator::Stop(Seconds(21.0));
+    Simulator::Run();
+    topology.Report();
+    Simulator::Destroy();
+}
@@ -0,0 +1,146 @@
+// Query tool for the result store written by Topology.
+//
+//   results-query <db> runs
+//   results-query <db> metrics <run>
+//   results-query <db> metric <kind> <metric>
+//   results-query <db> sweep <parameter> <kind> <metric>
+//   results-query <db> sql "<statement>"
+//
+// Output is tab separated with a header row, so it pipes straight into
+// column, awk or a plotting script.
+
+#include <cstdlib>
+#include <iostream>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const char* kRuns = "SELECT id, started, config, config_hash, wall_seconds, sim_seconds "
+                    "FROM runs ORDER BY id;";
+
+const char* kMetrics = "SELECT kind, entity, metric, value FROM metrics WHERE run_id = ?1 "
+                       "ORDER BY kind, entity, metric;";
+
+const char* kMetric = "SELECT run_id, entity, value FROM metrics WHERE kind = ?1 AND metric = ?2 "
+                      "ORDER BY run_id, entity;";
+
+// Mean, minimum and maximum of one metric over every entity and run that
+// share a value of the given parameter.
+const char* kSweep = "SELECT p.value AS parameter, COUNT(DISTINCT m.run_id) AS runs, "
+                     "AVG(m.value) AS mean, MIN(m.value) AS min, MAX(m.value) AS max "
+                     "FROM metrics m JOIN parameters p ON p.run_id = m.run_id "
+                     "WHERE p.key = ?1 AND m.kind = ?2 AND m.metric = ?3 "
+                     "GROUP BY p.value ORDER BY p.value;";
+
+int
+Usage()
+{
+    std::cerr << "usage: results-query <db> runs\n"
+              << "       results-query <db> metrics <run>\n"
+              << "       results-query <db> metric <kind> <metric>\n"
+              << "       results-query <db> sweep <parameter> <kind> <metric>\n"
+              << "       results-query <db> sql \"<statement>\"" << std::endl;
+    return 2;
+}
+
+int
+Query(sqlite3* db, const char* sql, const std::vector<std::string>& arguments)
+{
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        std::cerr << "error: " << sqlite3_errmsg(db) << std::endl;
+        return 1;
+    }
+
+    for (size_t i = 0; i < arguments.size(); ++i)
+    {
+        sqlite3_bind_text(stmt,
+                          static_cast<int>(i + 1),
+                          arguments[i].c_str(),
+                          -1,
+                          SQLITE_TRANSIENT);
+    }
+
+    int columns = sqlite3_column_count(stmt);
+    for (int c = 0; c < columns; ++c)
+    {
+        std::cout << (c ? "\t" : "") << sqlite3_column_name(stmt, c);
+    }
+    if (columns > 0)
+    {
+        std::cout << '\n';
+    }
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        for (int c = 0; c < columns; ++c)
+        {
+            auto text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, c));
+            std::cout << (c ? "\t" : "") << (text ? text : "NULL");
+        }
+        std::cout << '\n';
+    }
+
+    if (rc != SQLITE_DONE)
+    {
+        std::cerr << "error: " << sqlite3_errmsg(db) << std::endl;
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? 0 : 1;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        return Usage();
+    }
+
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(argv[1], &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK)
+    {
+        std::cerr << "error: cannot open " << argv[1] << ": " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return 1;
+    }
+
+    std::string command = argv[2];
+    std::vector<std::string> arguments(argv + 3, argv + argc);
+
+    int status;
+    if (command == "runs" && arguments.empty())
+    {
+        status = Query(db, kRuns, arguments);
+    }
+    else if (command == "metrics" && arguments.size() == 1)
+    {
+        status = Query(db, kMetrics, arguments);
+    }
+    else if (command == "metric" && arguments.size() == 2)
+    {
+        status = Query(db, kMetric, arguments);
+    }
+    else if (command == "sweep" && arguments.size() == 3)
+    {
+        status = Query(db, kSweep, arguments);
+    }
+    else if (command == "sql" && arguments.size() == 1)
+    {
+        status = Query(db, arguments[0].c_str(), {});
+    }
+    else
+    {
+        status = Usage();
+    }
+
+    sqlite3_close(db);
+    return status;
+}
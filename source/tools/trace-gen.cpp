@@ -0,0 +1,103 @@
+// Writes a compact TRC1 trace for TraceReplayApp.
+//
+//   trace-gen <out> [seconds] [fps] [kbps] [gop] [seed]
+//
+// Frames follow a simple GOP model: an I frame every <gop> frames at five
+// times the size of the P frames in between, with +-20% jitter, so the mean
+// rate matches <kbps>. Each frame is cut into packets of at most 1316 bytes
+// (seven MPEG-TS cells) spread evenly over the frame interval.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace
+{
+
+constexpr uint32_t kMagic = 0x31435254; // "TRC1"
+constexpr uint32_t kMaxPacket = 1316;
+
+void
+Write32(std::ofstream& out, uint32_t value)
+{
+    char bytes[4] = {char(value & 0xff),
+                     char((value >> 8) & 0xff),
+                     char((value >> 16) & 0xff),
+                     char((value >> 24) & 0xff)};
+    out.write(bytes, 4);
+}
+
+int
+Usage()
+{
+    std::cerr << "usage: trace-gen <out> [seconds] [fps] [kbps] [gop] [seed]" << std::endl;
+    return 2;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 7)
+    {
+        return Usage();
+    }
+
+    std::string path = argv[1];
+    double seconds = argc > 2 ? std::atof(argv[2]) : 10.0;
+    double fps = argc > 3 ? std::atof(argv[3]) : 25.0;
+    double kbps = argc > 4 ? std::atof(argv[4]) : 500.0;
+    uint32_t gop = argc > 5 ? std::atoi(argv[5]) : 12;
+    uint32_t seed = argc > 6 ? std::atoi(argv[6]) : 1;
+    if (seconds <= 0 || fps <= 0 || kbps <= 0 || gop == 0)
+    {
+        return Usage();
+    }
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        std::cerr << "error: cannot write " << path << std::endl;
+        return 1;
+    }
+    Write32(out, kMagic);
+
+    // One I frame weighs as much as five P frames.
+    double frameBytes = kbps * 1000 / 8 / fps;
+    double unit = frameBytes * gop / (gop + 4);
+    double interval = 1e6 / fps;
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> jitter(0.8, 1.2);
+
+    auto frames = static_cast<uint32_t>(seconds * fps);
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    double pending = 0; // microseconds since the previous record
+    for (uint32_t f = 0; f < frames; ++f)
+    {
+        auto size = static_cast<uint32_t>((f % gop == 0 ? 5 : 1) * unit * jitter(random));
+        uint32_t packets = std::max<uint32_t>((size + kMaxPacket - 1) / kMaxPacket, 1);
+        double spacing = interval / packets;
+
+        for (uint32_t p = 0; p < packets; ++p)
+        {
+            uint32_t payload = std::min(size, kMaxPacket);
+            size -= payload;
+            Write32(out, static_cast<uint32_t>(pending));
+            Write32(out, std::max<uint32_t>(payload, 1));
+            pending = spacing;
+            ++records;
+            bytes += payload;
+        }
+    }
+
+    std::cout << path << ": " << records << " records, " << bytes << " bytes over " << seconds
+              << "s" << std::endl;
+    return out ? 0 : 1;
+}
@@ -0,0 +1,302 @@
+#include "amt-header.h"
+
+#include <ns3/buffer.h>
+#include <ns3/header.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/type-id.h>
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+using namespace ns3;
+
+NS_OBJECT_ENSURE_REGISTERED(AmtHeader);
+
+namespace
+{
+
+void
+WriteMappedAddress(Buffer::Iterator& i, Ipv4Address address)
+{
+    for (int n = 0; n < 10; ++n)
+    {
+        i.WriteU8(0);
+    }
+    i.WriteU16(0xffff);
+    i.WriteHtonU32(address.Get());
+}
+
+Ipv4Address
+ReadMappedAddress(Buffer::Iterator& i)
+{
+    i.Next(12);
+    return Ipv4Address(i.ReadNtohU32());
+}
+
+} // namespace
+
+TypeId
+AmtHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("AmtHeader")
+                            .SetParent<Header>()
+                            .SetGroupName("Internet")
+                            .AddConstructor<AmtHeader>();
+    return tid;
+}
+
+TypeId
+AmtHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+AmtHeader::AmtHeader()
+    : AmtHeader(MULTICAST_DATA)
+{
+}
+
+AmtHeader::AmtHeader(MessageType type)
+    : m_type(type),
+      m_version(VERSION),
+      m_valid(true),
+      m_nonce(0),
+      m_responseMac(0),
+      m_p(false),
+      m_l(false),
+      m_g(false),
+      m_gatewayPort(0)
+{
+}
+
+uint32_t
+AmtHeader::FixedSize(MessageType type)
+{
+    switch (type)
+    {
+    case RELAY_DISCOVERY:
+        return 8;
+    case RELAY_ADVERTISEMENT:
+        return 12;
+    case REQUEST:
+        return 8;
+    case MEMBERSHIP_QUERY:
+        return 12;
+    case MEMBERSHIP_UPDATE:
+        return 12;
+    case MULTICAST_DATA:
+        return 2;
+    case TEARDOWN:
+        return 30;
+    }
+    return 2;
+}
+
+uint32_t
+AmtHeader::QueryLength(Buffer::Iterator i)
+{
+    // Total length for IPv4, payload length plus the fixed header for IPv6.
+    if (i.GetRemainingSize() < 6)
+    {
+        return 0;
+    }
+    uint8_t version = i.ReadU8() >> 4;
+    if (version == 4)
+    {
+        i.Next(1);
+        return i.ReadNtohU16();
+    }
+    if (version == 6)
+    {
+        i.Next(3);
+        return 40 + i.ReadNtohU16();
+    }
+    return 0;
+}
+
+void
+AmtHeader::Print(std::ostream& os) const
+{
+    os << "AMT v" << uint32_t(m_version) << " type=" << uint32_t(m_type);
+    switch (m_type)
+    {
+    case RELAY_DISCOVERY:
+    case REQUEST:
+        os << " nonce=" << m_nonce;
+        break;
+    case RELAY_ADVERTISEMENT:
+        os << " nonce=" << m_nonce << " relay=" << m_relayAddress;
+        break;
+    case MEMBERSHIP_QUERY:
+        os << " mac=" << m_responseMac << " nonce=" << m_nonce << " query=" << m_query.size();
+        if (m_g)
+        {
+            os << " gateway=" << m_gatewayAddress << ":" << m_gatewayPort;
+        }
+        break;
+    case MEMBERSHIP_UPDATE:
+        os << " mac=" << m_responseMac << " nonce=" << m_nonce;
+        break;
+    case TEARDOWN:
+        os << " mac=" << m_responseMac << " nonce=" << m_nonce << " gateway=" << m_gatewayAddress
+           << ":" << m_gatewayPort;
+        break;
+    case MULTICAST_DATA:
+        break;
+    }
+}
+
+uint32_t
+AmtHeader::GetSerializedSize() const
+{
+    if (m_type == MEMBERSHIP_QUERY)
+    {
+        return FixedSize(m_type) + m_query.size() + (m_g ? 18 : 0);
+    }
+    return FixedSize(m_type);
+}
+
+void
+AmtHeader::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteU8(static_cast<uint8_t>((m_version << 4) | (m_type & 0x0f)));
+
+    switch (m_type)
+    {
+    case RELAY_DISCOVERY:
+        i.WriteU8(0);
+        i.WriteU16(0);
+        i.WriteHtonU32(m_nonce);
+        break;
+    case RELAY_ADVERTISEMENT:
+        i.WriteU8(0);
+        i.WriteU16(0);
+        i.WriteHtonU32(m_nonce);
+        i.WriteHtonU32(m_relayAddress.Get());
+        break;
+    case REQUEST:
+        i.WriteU8(m_p ? 0x01 : 0x00);
+        i.WriteU16(0);
+        i.WriteHtonU32(m_nonce);
+        break;
+    case MEMBERSHIP_QUERY:
+        i.WriteU8((m_l ? 0x02 : 0x00) | (m_g ? 0x01 : 0x00));
+        i.WriteHtonU16(static_cast<uint16_t>(m_responseMac >> 32));
+        i.WriteHtonU32(static_cast<uint32_t>(m_responseMac));
+        i.WriteHtonU32(m_nonce);
+        if (!m_query.empty())
+        {
+            i.Write(m_query.data(), m_query.size());
+        }
+        if (m_g)
+        {
+            i.WriteHtonU16(m_gatewayPort);
+            WriteMappedAddress(i, m_gatewayAddress);
+        }
+        break;
+    case MEMBERSHIP_UPDATE:
+        i.WriteU8(0);
+        i.WriteHtonU16(static_cast<uint16_t>(m_responseMac >> 32));
+        i.WriteHtonU32(static_cast<uint32_t>(m_responseMac));
+        i.WriteHtonU32(m_nonce);
+        break;
+    case MULTICAST_DATA:
+        i.WriteU8(0);
+        break;
+    case TEARDOWN:
+        i.WriteU8(0);
+        i.WriteHtonU16(static_cast<uint16_t>(m_responseMac >> 32));
+        i.WriteHtonU32(static_cast<uint32_t>(m_responseMac));
+        i.WriteHtonU32(m_nonce);
+        i.WriteHtonU16(m_gatewayPort);
+        WriteMappedAddress(i, m_gatewayAddress);
+        break;
+    }
+}
+
+uint32_t
+AmtHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    m_valid = false;
+
+    if (i.GetRemainingSize() < 2)
+    {
+        return 0;
+    }
+
+    uint8_t first = i.ReadU8();
+    uint8_t flags = i.ReadU8();
+    m_version = first >> 4;
+    uint8_t type = first & 0x0f;
+    if (m_version != VERSION || type < RELAY_DISCOVERY || type > TEARDOWN)
+    {
+        return 2;
+    }
+    m_type = static_cast<MessageType>(type);
+    m_p = false;
+    m_l = false;
+    m_g = false;
+
+    if (m_type == MEMBERSHIP_QUERY)
+    {
+        m_l = (flags & 0x02) != 0;
+        m_g = (flags & 0x01) != 0;
+    }
+    else if (m_type == REQUEST)
+    {
+        m_p = (flags & 0x01) != 0;
+    }
+
+    uint32_t size = FixedSize(m_type);
+    if (i.GetRemainingSize() + 2 < size)
+    {
+        return 2;
+    }
+    m_query.clear();
+
+    switch (m_type)
+    {
+    case RELAY_DISCOVERY:
+    case REQUEST:
+        i.Next(2);
+        m_nonce = i.ReadNtohU32();
+        break;
+    case RELAY_ADVERTISEMENT:
+        i.Next(2);
+        m_nonce = i.ReadNtohU32();
+        m_relayAddress = Ipv4Address(i.ReadNtohU32());
+        break;
+    case MEMBERSHIP_QUERY:
+    case MEMBERSHIP_UPDATE:
+    case TEARDOWN:
+        m_responseMac = uint64_t(i.ReadNtohU16()) << 32;
+        m_responseMac |= i.ReadNtohU32();
+        m_nonce = i.ReadNtohU32();
+        if (m_type == MEMBERSHIP_QUERY)
+        {
+            uint32_t query = QueryLength(i);
+            uint32_t trailer = m_g ? 18 : 0;
+            if (i.GetRemainingSize() < query + trailer)
+            {
+                return size;
+            }
+            m_query.resize(query);
+            i.Read(m_query.data(), query);
+            size += query + trailer;
+        }
+        if (m_type == TEARDOWN || m_g)
+        {
+            m_gatewayPort = i.ReadNtohU16();
+            m_gatewayAddress = ReadMappedAddress(i);
+        }
+        break;
+    case MULTICAST_DATA:
+        break;
+    }
+
+    m_valid = true;
+    return size;
+}
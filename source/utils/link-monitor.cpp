@@ -0,0 +1,200 @@
+#include "link-monitor.h"
+
+#include <ns3/callback.h>
+#include <ns3/data-rate.h>
+#include <ns3/ethernet-header.h>
+#include <ns3/ipv4-header.h>
+#include <ns3/net-device-container.h>
+#include <ns3/net-device.h>
+#include <ns3/node.h>
+#include <ns3/nstime.h>
+#include <ns3/packet.h>
+#include <ns3/ptr.h>
+#include <ns3/queue-disc.h>
+#include <ns3/queue-item.h>
+#include <ns3/traffic-control-layer.h>
+#include <ns3/udp-header.h>
+
+#include <cstdint>
+#include <iomanip>
+#include <ios>
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+void
+LinkMonitor::Install(const std::string& link, const NetDeviceContainer& devices, DataRate rate)
+{
+    LinkCounters& counters = m_links[link];
+    counters.name = link;
+    counters.rate = rate;
+
+    for (uint32_t i = 0; i < devices.GetN(); ++i)
+    {
+        Ptr<NetDevice> device = devices.Get(i);
+        device->TraceConnectWithoutContext(
+            "PhyTxEnd",
+            MakeBoundCallback(&LinkMonitor::PhyTxEnd, this, &counters));
+        device->TraceConnectWithoutContext("MacTxDrop",
+                                           MakeBoundCallback(&LinkMonitor::Drop, &counters));
+        device->TraceConnectWithoutContext("PhyTxDrop",
+                                           MakeBoundCallback(&LinkMonitor::Drop, &counters));
+        device->TraceConnectWithoutContext("PhyRxDrop",
+                                           MakeBoundCallback(&LinkMonitor::Drop, &counters));
+
+        auto tc = device->GetNode()->GetObject<TrafficControlLayer>();
+        if (Ptr<QueueDisc> disc = tc ? tc->GetRootQueueDiscOnDevice(device) : nullptr)
+        {
+            disc->TraceConnectWithoutContext("Drop",
+                                             MakeBoundCallback(&LinkMonitor::QueueDrop, &counters));
+        }
+    }
+}
+
+void
+LinkMonitor::AddAmtPort(uint16_t port)
+{
+    m_amtPorts.insert(port);
+}
+
+void
+LinkMonitor::PhyTxEnd(LinkMonitor* monitor, LinkCounters* link, Ptr<const Packet> p)
+{
+    ++link->packets;
+    link->bytes += p->GetSize();
+    monitor->Classify(*link, p);
+}
+
+void
+LinkMonitor::Drop(LinkCounters* link, Ptr<const Packet> p)
+{
+    ++link->drops;
+}
+
+void
+LinkMonitor::QueueDrop(LinkCounters* link, Ptr<const QueueDiscItem> item)
+{
+    ++link->drops;
+}
+
+void
+LinkMonitor::Classify(LinkCounters& link, Ptr<const Packet> p)
+{
+    Ptr<Packet> copy = p->Copy();
+
+    EthernetHeader ethernet(false);
+    copy->RemoveHeader(ethernet);
+    if (ethernet.GetLengthType() != 0x0800)
+    {
+        return;
+    }
+
+    Ipv4Header ip;
+    copy->RemoveHeader(ip);
+    // Link-local groups carry routing control, not multicast data.
+    if (ip.GetDestination().IsMulticast() && !ip.GetDestination().IsLocalMulticast())
+    {
+        ++link.multicastPackets;
+        link.multicastBytes += p->GetSize();
+        return;
+    }
+    if (ip.GetProtocol() != 17)
+    {
+        return;
+    }
+
+    auto endpoints = std::make_pair(ip.GetSource().Get(), ip.GetDestination().Get());
+    bool amt = false;
+    if (ip.GetFragmentOffset() == 0)
+    {
+        UdpHeader udp;
+        copy->PeekHeader(udp);
+        amt = m_amtPorts.count(udp.GetSourcePort()) || m_amtPorts.count(udp.GetDestinationPort());
+        if (amt)
+        {
+            m_tunnels.insert(endpoints);
+
+            // Only data messages carry a datagram the encapsulation is
+            // overhead on; control messages and later fragments do not.
+            uint8_t amtType = 0;
+            copy->RemoveHeader(udp);
+            if (copy->GetSize() > 0 && copy->CopyData(&amtType, 1) && (amtType & 0x0f) == 6)
+            {
+                ++link.amtDataPackets;
+            }
+        }
+    }
+    else
+    {
+        amt = m_tunnels.count(endpoints) > 0;
+    }
+
+    if (amt)
+    {
+        ++link.amtPackets;
+        link.amtBytes += p->GetSize();
+    }
+}
+
+void
+LinkMonitor::Report(Time duration) const
+{
+    std::cout << "link report" << std::endl;
+    // Keep the fixed precision below from leaking into later reports.
+    std::ios format(nullptr);
+    format.copyfmt(std::cout);
+
+    uint64_t multicastBytes = 0;
+    uint64_t amtBytes = 0;
+    uint64_t amtDataPackets = 0;
+    for (auto& [name, link] : m_links)
+    {
+        double capacity = link.rate.GetBitRate() * duration.GetSeconds();
+        double utilization = capacity > 0 ? link.bytes * 8.0 / capacity : 0.0;
+
+        std::cout << "  " << name << ": " << std::fixed << std::setprecision(2)
+                  << utilization * 100 << "% utilization, " << link.packets << " packets, "
+                  << link.bytes << " bytes, " << link.drops << " drops, multicast "
+                  << link.multicastBytes << " bytes, amt " << link.amtBytes << " bytes"
+                  << std::endl;
+
+        multicastBytes += link.multicastBytes;
+        amtBytes += link.amtBytes;
+        amtDataPackets += link.amtDataPackets;
+    }
+
+    // Byte-hops: every link a byte crosses counts once. The outer IPv4, UDP
+    // and AMT headers are the tunnel's own overhead on top of the datagram.
+    uint64_t tunnelOverhead = amtDataPackets * (20 + 8 + 2);
+    uint64_t delivery = multicastBytes + amtBytes;
+    std::cout << "  native multicast: " << multicastBytes << " byte-hops" << std::endl;
+    std::cout << "  amt tunnels: " << amtBytes << " byte-hops (" << tunnelOverhead
+              << " of encapsulation)" << std::endl;
+    if (delivery > 0)
+    {
+        std::cout << "  amt share of multicast byte-hops: " << std::setprecision(2)
+                  << 100.0 * amtBytes / delivery << "%" << std::endl;
+    }
+    std::cout.copyfmt(format);
+}
+
+void
+LinkMonitor::Record(ResultStore& store, Time duration) const
+{
+    for (auto& [name, link] : m_links)
+    {
+        double capacity = link.rate.GetBitRate() * duration.GetSeconds();
+        store.AddMetric("link",
+                        name,
+                        "utilization",
+                        capacity > 0 ? link.bytes * 8.0 / capacity : 0.0);
+        store.AddMetric("link", name, "packets", link.packets);
+        store.AddMetric("link", name, "bytes", link.bytes);
+        store.AddMetric("link", name, "drops", link.drops);
+        store.AddMetric("link", name, "multicast_bytes", link.multicastBytes);
+        store.AddMetric("link", name, "amt_packets", link.amtPackets);
+        store.AddMetric("link", name, "amt_bytes", link.amtBytes);
+        store.AddMetric("link", name, "amt_data_packets", link.amtDataPackets);
+    }
+}
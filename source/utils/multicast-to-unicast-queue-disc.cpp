@@ -0,0 +1,120 @@
+#include "multicast-to-unicast-queue-disc.h"
+
+#include <ns3/drop-tail-queue.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/ipv4-queue-disc-item.h>
+#include <ns3/mac48-address.h>
+#include <ns3/ptr.h>
+#include <ns3/queue-disc.h>
+#include <ns3/queue-size.h>
+#include <ns3/type-id.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace ns3;
+
+NS_OBJECT_ENSURE_REGISTERED(MulticastToUnicastQueueDisc);
+
+TypeId
+MulticastToUnicastQueueDisc::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("MulticastToUnicastQueueDisc")
+            .SetParent<QueueDisc>()
+            .SetGroupName("TrafficControl")
+            .AddConstructor<MulticastToUnicastQueueDisc>()
+            .AddAttribute("MaxSize",
+                          "The max queue size",
+                          QueueSizeValue(QueueSize("1000p")),
+                          MakeQueueSizeAccessor(&QueueDisc::SetMaxSize, &QueueDisc::GetMaxSize),
+                          MakeQueueSizeChecker());
+    return tid;
+}
+
+MulticastToUnicastQueueDisc::MulticastToUnicastQueueDisc()
+    : QueueDisc(QueueDiscSizePolicy::SINGLE_INTERNAL_QUEUE),
+      m_converted(0)
+{
+}
+
+MulticastToUnicastQueueDisc::~MulticastToUnicastQueueDisc()
+{
+}
+
+void
+MulticastToUnicastQueueDisc::SetStations(const std::vector<Mac48Address>& stations)
+{
+    m_stations = stations;
+}
+
+bool
+MulticastToUnicastQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
+{
+    if (GetCurrentSize() + item > GetMaxSize())
+    {
+        DropBeforeEnqueue(item, LIMIT_EXCEEDED_DROP);
+        return false;
+    }
+
+    // Copies come back through Enqueue with the multicast IPv4 header but a
+    // station's unicast MAC, and must not be converted again.
+    auto ipv4Item = DynamicCast<Ipv4QueueDiscItem>(item);
+    if (m_stations.empty() || !ipv4Item || !ipv4Item->GetHeader().GetDestination().IsMulticast() ||
+        !Mac48Address::IsMatchingType(item->GetAddress()) ||
+        !Mac48Address::ConvertFrom(item->GetAddress()).IsGroup())
+    {
+        return GetInternalQueue(0)->Enqueue(item);
+    }
+
+    ++m_converted;
+    auto copy = [&ipv4Item](const Mac48Address& station) {
+        return Create<Ipv4QueueDiscItem>(ipv4Item->GetPacket()->Copy(),
+                                         station,
+                                         ipv4Item->GetProtocol(),
+                                         ipv4Item->GetHeader());
+    };
+
+    // The first copy takes the place of the datagram. The others go through
+    // Enqueue as arrivals of their own, so the queue's length, byte count and
+    // drops include the whole conversion backlog.
+    if (!GetInternalQueue(0)->Enqueue(copy(m_stations.front())))
+    {
+        return false;
+    }
+    for (size_t i = 1; i < m_stations.size(); ++i)
+    {
+        Enqueue(copy(m_stations[i]));
+    }
+    return true;
+}
+
+Ptr<QueueDiscItem>
+MulticastToUnicastQueueDisc::DoDequeue()
+{
+    return GetInternalQueue(0)->Dequeue();
+}
+
+bool
+MulticastToUnicastQueueDisc::CheckConfig()
+{
+    if (GetNQueueDiscClasses() > 0 || GetNPacketFilters() > 0)
+    {
+        return false;
+    }
+
+    if (GetNInternalQueues() == 0)
+    {
+        AddInternalQueue(CreateObjectWithAttributes<DropTailQueue<QueueDiscItem>>(
+            "MaxSize",
+            QueueSizeValue(GetMaxSize())));
+    }
+
+    return GetNInternalQueues() == 1;
+}
+
+void
+MulticastToUnicastQueueDisc::InitializeParams()
+{
+}
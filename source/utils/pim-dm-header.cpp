@@ -0,0 +1,171 @@
+#include "pim-dm-header.h"
+
+#include <ns3/buffer.h>
+#include <ns3/header.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/type-id.h>
+
+#include <cstdint>
+#include <ostream>
+
+using namespace ns3;
+
+NS_OBJECT_ENSURE_REGISTERED(PimDmHeader);
+
+namespace
+{
+
+constexpr uint8_t kFamilyIpv4 = 1;
+constexpr uint16_t kOptionHoldTime = 1;
+constexpr uint8_t kSparseBit = 0x04;
+
+constexpr uint32_t kHelloSize = 4 + 6;
+// Common header, encoded upstream, reserved/count/holdtime, encoded group,
+// joined/pruned counts, encoded source.
+constexpr uint32_t kJoinPruneSize = 4 + 6 + 4 + 8 + 4 + 8;
+
+void
+WriteEncoded(Buffer::Iterator& i, Ipv4Address address, uint8_t flags, bool masked)
+{
+    i.WriteU8(kFamilyIpv4);
+    i.WriteU8(0);
+    if (masked)
+    {
+        i.WriteU8(flags);
+        i.WriteU8(32);
+    }
+    i.WriteHtonU32(address.Get());
+}
+
+bool
+ReadEncoded(Buffer::Iterator& i, Ipv4Address& address, bool masked)
+{
+    uint8_t family = i.ReadU8();
+    i.Next(masked ? 3 : 1);
+    address = Ipv4Address(i.ReadNtohU32());
+    return family == kFamilyIpv4;
+}
+
+} // namespace
+
+TypeId
+PimDmHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("PimDmHeader")
+                            .SetParent<Header>()
+                            .SetGroupName("Internet")
+                            .AddConstructor<PimDmHeader>();
+    return tid;
+}
+
+TypeId
+PimDmHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+PimDmHeader::PimDmHeader()
+    : PimDmHeader(HELLO)
+{
+}
+
+PimDmHeader::PimDmHeader(MessageType type)
+    : m_type(type),
+      m_valid(true),
+      m_holdTime(0),
+      m_prune(false)
+{
+}
+
+void
+PimDmHeader::Print(std::ostream& os) const
+{
+    os << "PIM-DM type=" << uint32_t(m_type) << " holdtime=" << m_holdTime;
+    if (m_type != HELLO)
+    {
+        os << " upstream=" << m_upstream << " (" << m_source << "," << m_group << ") "
+           << (m_prune ? "prune" : "join");
+    }
+}
+
+uint32_t
+PimDmHeader::GetSerializedSize() const
+{
+    return m_type == HELLO ? kHelloSize : kJoinPruneSize;
+}
+
+void
+PimDmHeader::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteU8(static_cast<uint8_t>((VERSION << 4) | (m_type & 0x0f)));
+    i.WriteU8(0);
+    i.WriteU16(0);
+
+    if (m_type == HELLO)
+    {
+        i.WriteHtonU16(kOptionHoldTime);
+        i.WriteHtonU16(2);
+        i.WriteHtonU16(m_holdTime);
+        return;
+    }
+
+    WriteEncoded(i, m_upstream, 0, false);
+    i.WriteU8(0);
+    i.WriteU8(1);
+    i.WriteHtonU16(m_holdTime);
+    WriteEncoded(i, m_group, 0, true);
+    i.WriteHtonU16(m_prune ? 0 : 1);
+    i.WriteHtonU16(m_prune ? 1 : 0);
+    WriteEncoded(i, m_source, kSparseBit, true);
+}
+
+uint32_t
+PimDmHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    m_valid = false;
+
+    if (i.GetRemainingSize() < 4)
+    {
+        return 0;
+    }
+
+    uint8_t first = i.ReadU8();
+    i.Next(3);
+    uint8_t type = first & 0x0f;
+    if ((first >> 4) != VERSION ||
+        (type != HELLO && type != JOIN_PRUNE && type != GRAFT && type != GRAFT_ACK))
+    {
+        return 4;
+    }
+    m_type = static_cast<MessageType>(type);
+
+    uint32_t size = GetSerializedSize();
+    if (i.GetRemainingSize() + 4 < size)
+    {
+        return 4;
+    }
+
+    if (m_type == HELLO)
+    {
+        uint16_t option = i.ReadNtohU16();
+        uint16_t length = i.ReadNtohU16();
+        m_holdTime = i.ReadNtohU16();
+        m_valid = option == kOptionHoldTime && length == 2;
+        return size;
+    }
+
+    bool encoded = ReadEncoded(i, m_upstream, false);
+    i.Next(1);
+    uint8_t groups = i.ReadU8();
+    m_holdTime = i.ReadNtohU16();
+    encoded = ReadEncoded(i, m_group, true) && encoded;
+    uint16_t joined = i.ReadNtohU16();
+    uint16_t pruned = i.ReadNtohU16();
+    encoded = ReadEncoded(i, m_source, true) && encoded;
+
+    m_prune = pruned == 1;
+    m_valid = encoded && groups == 1 && joined + pruned == 1;
+    return size;
+}
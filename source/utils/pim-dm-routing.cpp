@@ -0,0 +1,799 @@
+#include "pim-dm-routing.h"
+
+#include "pim-dm-header.h"
+
+#include <ns3/callback.h>
+#include <ns3/fatal-error.h>
+#include <ns3/inet-socket-address.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/ipv4-header.h>
+#include <ns3/ipv4-interface-address.h>
+#include <ns3/ipv4-packet-info-tag.h>
+#include <ns3/ipv4-route.h>
+#include <ns3/names.h>
+#include <ns3/net-device.h>
+#include <ns3/node.h>
+#include <ns3/nstime.h>
+#include <ns3/output-stream-wrapper.h>
+#include <ns3/packet.h>
+#include <ns3/ptr.h>
+#include <ns3/simulator.h>
+#include <ns3/socket.h>
+#include <ns3/type-id.h>
+#include <ns3/udp-socket-factory.h>
+#include <ns3/uinteger.h>
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+using namespace ns3;
+
+NS_OBJECT_ENSURE_REGISTERED(PimDmRouting);
+
+namespace
+{
+
+const Ipv4Address kAllPimRouters("224.0.0.13");
+
+} // namespace
+
+TypeId
+PimDmRouting::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("PimDmRouting")
+            .SetParent<Ipv4RoutingProtocol>()
+            .SetGroupName("Internet")
+            .AddConstructor<PimDmRouting>()
+            .AddAttribute("HelloInterval",
+                          "Interval between Hello messages on each interface",
+                          TimeValue(Seconds(30)),
+                          MakeTimeAccessor(&PimDmRouting::m_helloInterval),
+                          MakeTimeChecker())
+            .AddAttribute("TriggeredHelloDelay",
+                          "Upper bound of the random delay before the first Hello",
+                          TimeValue(Seconds(5)),
+                          MakeTimeAccessor(&PimDmRouting::m_triggeredHelloDelay),
+                          MakeTimeChecker())
+            .AddAttribute("PruneHoldTime",
+                          "How long a downstream interface stays pruned",
+                          TimeValue(Seconds(210)),
+                          MakeTimeAccessor(&PimDmRouting::m_pruneHoldTime),
+                          MakeTimeChecker())
+            // t_limit of RFC 3973, section 4.8.
+            .AddAttribute("PruneLimitInterval",
+                          "Minimum time between two Prunes for the same (S,G)",
+                          TimeValue(Seconds(60)),
+                          MakeTimeAccessor(&PimDmRouting::m_pruneLimitInterval),
+                          MakeTimeChecker())
+            .AddAttribute("OverrideInterval",
+                          "Delay before a Prune on a multi-access link takes effect",
+                          TimeValue(Seconds(3)),
+                          MakeTimeAccessor(&PimDmRouting::m_overrideInterval),
+                          MakeTimeChecker())
+            .AddAttribute("GraftRetryInterval",
+                          "Interval between Graft retransmissions",
+                          TimeValue(Seconds(3)),
+                          MakeTimeAccessor(&PimDmRouting::m_graftRetryInterval),
+                          MakeTimeChecker());
+    return tid;
+}
+
+PimDmRouting::PimDmRouting()
+    : m_ipv4(nullptr),
+      m_recvSocket(nullptr),
+      m_initialized(false),
+      m_random(CreateObject<UniformRandomVariable>()),
+      m_received(0),
+      m_forwarded(0),
+      m_rpfFailures(0),
+      m_pruneOverrides(0)
+{
+}
+
+PimDmRouting::~PimDmRouting()
+{
+}
+
+void
+PimDmRouting::DoInitialize()
+{
+    for (uint32_t i = 1; i < m_ipv4->GetNInterfaces(); ++i)
+    {
+        if (m_ipv4->IsUp(i))
+        {
+            CreateSocket(i);
+        }
+    }
+
+    m_recvSocket = Socket::CreateSocket(m_ipv4->GetObject<Node>(), UdpSocketFactory::GetTypeId());
+    if (m_recvSocket->Bind(InetSocketAddress(kAllPimRouters, PIM_PORT)) == -1)
+    {
+        NS_FATAL_ERROR("Failed to bind PIM socket");
+    }
+    m_recvSocket->SetRecvPktInfo(true);
+    m_recvSocket->SetRecvCallback(MakeCallback(&PimDmRouting::Receive, this));
+
+    m_initialized = true;
+    m_helloEvent = Simulator::Schedule(
+        Seconds(m_random->GetValue(0, m_triggeredHelloDelay.GetSeconds())),
+        &PimDmRouting::SendHellos,
+        this);
+
+    Ipv4RoutingProtocol::DoInitialize();
+}
+
+void
+PimDmRouting::DoDispose()
+{
+    Simulator::Cancel(m_helloEvent);
+    for (auto& [key, entry] : m_entries)
+    {
+        Simulator::Cancel(entry.graftRetry);
+        for (auto& [interface, event] : entry.pendingPrunes)
+        {
+            Simulator::Cancel(event);
+        }
+    }
+    m_entries.clear();
+
+    for (auto& [interface, socket] : m_sockets)
+    {
+        socket->Close();
+    }
+    m_sockets.clear();
+    if (m_recvSocket)
+    {
+        m_recvSocket->Close();
+        m_recvSocket = nullptr;
+    }
+
+    m_ipv4 = nullptr;
+    m_random = nullptr;
+    Ipv4RoutingProtocol::DoDispose();
+}
+
+Ptr<Ipv4Route>
+PimDmRouting::RouteOutput(Ptr<Packet> p,
+                          const Ipv4Header& header,
+                          Ptr<NetDevice> oif,
+                          Socket::SocketErrno& sockerr)
+{
+    // Only link-local control traffic sent on a chosen interface is routed
+    // here; everything else falls through to the static and global protocols.
+    Ipv4Address destination = header.GetDestination();
+    if (!destination.IsLocalMulticast() || !oif)
+    {
+        sockerr = Socket::ERROR_NOROUTETOHOST;
+        return nullptr;
+    }
+
+    int32_t interface = m_ipv4->GetInterfaceForDevice(oif);
+    if (interface < 0 || m_ipv4->GetNAddresses(interface) == 0)
+    {
+        sockerr = Socket::ERROR_NOROUTETOHOST;
+        return nullptr;
+    }
+
+    auto route = Create<Ipv4Route>();
+    route->SetDestination(destination);
+    route->SetGateway(Ipv4Address::GetZero());
+    route->SetOutputDevice(oif);
+    route->SetSource(m_ipv4->GetAddress(interface, 0).GetLocal());
+    sockerr = Socket::ERROR_NOTERROR;
+    return route;
+}
+
+bool
+PimDmRouting::RouteInput(Ptr<const Packet> p,
+                         const Ipv4Header& header,
+                         Ptr<const NetDevice> idev,
+                         const UnicastForwardCallback& ucb,
+                         const MulticastForwardCallback& mcb,
+                         const LocalDeliverCallback& lcb,
+                         const ErrorCallback& ecb)
+{
+    Ipv4Address group = header.GetDestination();
+    if (!group.IsMulticast() || group.IsLocalMulticast())
+    {
+        return false;
+    }
+
+    int32_t iif = m_ipv4->GetInterfaceForDevice(idev);
+    Entry* entry = GetEntry(header.GetSource(), group);
+    if (iif < 0 || !entry)
+    {
+        return false;
+    }
+
+    Time now = Simulator::Now();
+    if (static_cast<uint32_t>(iif) != entry->iif)
+    {
+        ++m_rpfFailures;
+        // On a link with a single PIM neighbor that neighbor sent the copy,
+        // so prune it to stop the flood arriving the wrong way.
+        auto& limit = entry->nonRpfPruneLimit[iif];
+        if (NeighborCount(iif) == 1 && now >= limit)
+        {
+            Ipv4Address neighbor;
+            for (auto& [address, expires] : m_neighbors[iif])
+            {
+                if (expires > now)
+                {
+                    neighbor = address;
+                }
+            }
+            SendJoinPrune(iif, neighbor, *entry, true);
+            limit = now + m_pruneLimitInterval;
+        }
+        return true;
+    }
+
+    std::vector<uint32_t> interfaces = OutgoingInterfaces(*entry);
+    if (interfaces.empty())
+    {
+        if (!m_localMembers.count(group))
+        {
+            PruneUpstream(*entry);
+        }
+        return true;
+    }
+
+    auto route = Create<Ipv4MulticastRoute>();
+    route->SetGroup(group);
+    route->SetOrigin(header.GetSource());
+    route->SetParent(iif);
+    for (auto interface : interfaces)
+    {
+        route->SetOutputTtl(interface, Ipv4MulticastRoute::MAX_TTL - 1);
+    }
+    mcb(route, p, header);
+    ++m_forwarded;
+    return true;
+}
+
+void
+PimDmRouting::NotifyInterfaceUp(uint32_t interface)
+{
+    if (m_initialized)
+    {
+        CreateSocket(interface);
+    }
+}
+
+void
+PimDmRouting::NotifyInterfaceDown(uint32_t interface)
+{
+    auto it = m_sockets.find(interface);
+    if (it != m_sockets.end())
+    {
+        it->second->Close();
+        m_sockets.erase(it);
+    }
+    m_neighbors.erase(interface);
+}
+
+void
+PimDmRouting::NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address)
+{
+    if (m_initialized && m_ipv4->IsUp(interface))
+    {
+        CreateSocket(interface);
+    }
+}
+
+void
+PimDmRouting::NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address)
+{
+}
+
+void
+PimDmRouting::SetIpv4(Ptr<Ipv4> ipv4)
+{
+    NS_ASSERT(!m_ipv4 && ipv4);
+    m_ipv4 = ipv4;
+}
+
+void
+PimDmRouting::PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
+{
+    std::ostream* os = stream->GetStream();
+    Ptr<Node> node = m_ipv4->GetObject<Node>();
+    *os << "Node: " << Names::FindName(node) << ", Time: " << Simulator::Now().As(unit)
+        << ", PIM-DM" << std::endl;
+
+    for (auto& [key, entry] : m_entries)
+    {
+        *os << "  (" << entry.source << ", " << entry.group << ") iif " << entry.iif
+            << " upstream " << entry.upstream << (entry.upstreamPruned ? " pruned" : "")
+            << " oif";
+        for (auto interface : OutgoingInterfaces(entry))
+        {
+            *os << " " << interface;
+        }
+        *os << std::endl;
+    }
+}
+
+void
+PimDmRouting::AddMembership(uint32_t interface, Ipv4Address group)
+{
+    if (m_members[{interface, group}]++ == 0)
+    {
+        MembershipAdded(group);
+    }
+}
+
+void
+PimDmRouting::RemoveMembership(uint32_t interface, Ipv4Address group)
+{
+    // Leaving needs no message: the next datagram with nowhere to go prunes.
+    auto it = m_members.find({interface, group});
+    if (it != m_members.end() && --it->second == 0)
+    {
+        m_members.erase(it);
+    }
+}
+
+void
+PimDmRouting::AddLocalMembership(Ipv4Address group)
+{
+    if (m_localMembers[group]++ == 0)
+    {
+        MembershipAdded(group);
+    }
+}
+
+void
+PimDmRouting::RemoveLocalMembership(Ipv4Address group)
+{
+    auto it = m_localMembers.find(group);
+    if (it != m_localMembers.end() && --it->second == 0)
+    {
+        m_localMembers.erase(it);
+    }
+}
+
+uint32_t
+PimDmRouting::GetNeighbors() const
+{
+    uint32_t neighbors = 0;
+    for (auto& [interface, addresses] : m_neighbors)
+    {
+        neighbors += NeighborCount(interface);
+    }
+    return neighbors;
+}
+
+uint32_t
+PimDmRouting::GetForwardingInterfaces() const
+{
+    uint32_t interfaces = 0;
+    for (auto& [key, entry] : m_entries)
+    {
+        interfaces += OutgoingInterfaces(entry).size();
+    }
+    return interfaces;
+}
+
+uint32_t
+PimDmRouting::GetPrunedInterfaces() const
+{
+    Time now = Simulator::Now();
+    uint32_t interfaces = 0;
+    for (auto& [key, entry] : m_entries)
+    {
+        for (auto& [interface, until] : entry.prunedUntil)
+        {
+            interfaces += until > now;
+        }
+    }
+    return interfaces;
+}
+
+void
+PimDmRouting::CreateSocket(uint32_t interface)
+{
+    if (m_sockets.count(interface) || m_ipv4->GetNAddresses(interface) == 0)
+    {
+        return;
+    }
+
+    Ipv4Address address = m_ipv4->GetAddress(interface, 0).GetLocal();
+    if (address == Ipv4Address::GetLoopback())
+    {
+        return;
+    }
+
+    auto socket = Socket::CreateSocket(m_ipv4->GetObject<Node>(), UdpSocketFactory::GetTypeId());
+    if (socket->Bind(InetSocketAddress(address, PIM_PORT)) == -1)
+    {
+        NS_FATAL_ERROR("Failed to bind PIM socket on " << address);
+    }
+    socket->BindToNetDevice(m_ipv4->GetNetDevice(interface));
+    socket->SetAttribute("IpMulticastTtl", UintegerValue(1));
+    socket->SetRecvCallback(MakeCallback(&PimDmRouting::Receive, this));
+    m_sockets[interface] = socket;
+}
+
+void
+PimDmRouting::SendHellos()
+{
+    PimDmHeader hello(PimDmHeader::HELLO);
+    // RFC 3973 default: neighbors are kept for 3.5 Hello intervals.
+    hello.SetHoldTime(static_cast<uint16_t>(3.5 * m_helloInterval.GetSeconds()));
+    for (auto& [interface, socket] : m_sockets)
+    {
+        Send(interface, hello);
+    }
+    m_helloEvent = Simulator::Schedule(m_helloInterval, &PimDmRouting::SendHellos, this);
+}
+
+void
+PimDmRouting::Send(uint32_t interface, const PimDmHeader& header)
+{
+    auto it = m_sockets.find(interface);
+    if (it == m_sockets.end())
+    {
+        return;
+    }
+
+    auto packet = Create<Packet>();
+    packet->AddHeader(header);
+    if (it->second->SendTo(packet, 0, InetSocketAddress(kAllPimRouters, PIM_PORT)) < 0)
+    {
+        return;
+    }
+
+    switch (header.GetType())
+    {
+    case PimDmHeader::HELLO:
+        ++m_sent.hellos;
+        break;
+    case PimDmHeader::JOIN_PRUNE:
+        ++(header.IsPrune() ? m_sent.prunes : m_sent.joins);
+        break;
+    case PimDmHeader::GRAFT:
+        ++m_sent.grafts;
+        break;
+    case PimDmHeader::GRAFT_ACK:
+        ++m_sent.graftAcks;
+        break;
+    }
+    // Counted as on the wire: PIM message plus UDP and IPv4 headers.
+    m_sent.bytes += header.GetSerializedSize() + 8 + 20;
+}
+
+void
+PimDmRouting::SendJoinPrune(uint32_t interface,
+                            Ipv4Address upstream,
+                            const Entry& entry,
+                            bool prune)
+{
+    PimDmHeader message(PimDmHeader::JOIN_PRUNE);
+    message.SetUpstream(upstream);
+    message.SetGroup(entry.group);
+    message.SetSource(entry.source);
+    message.SetPrune(prune);
+    message.SetHoldTime(static_cast<uint16_t>(m_pruneHoldTime.GetSeconds()));
+    Send(interface, message);
+}
+
+void
+PimDmRouting::Receive(Ptr<Socket> socket)
+{
+    Ptr<Packet> packet;
+    Address from;
+    while ((packet = socket->RecvFrom(from)))
+    {
+        Ipv4PacketInfoTag info;
+        if (!packet->RemovePacketTag(info))
+        {
+            continue;
+        }
+        // The tag carries the device index, not the IPv4 interface index.
+        Ptr<NetDevice> device = m_ipv4->GetObject<Node>()->GetDevice(info.GetRecvIf());
+        int32_t interface = m_ipv4->GetInterfaceForDevice(device);
+        Ipv4Address source = InetSocketAddress::ConvertFrom(from).GetIpv4();
+        if (interface < 0 || m_ipv4->GetInterfaceForAddress(source) != -1)
+        {
+            continue;
+        }
+
+        PimDmHeader header;
+        packet->RemoveHeader(header);
+        if (!header.IsValid())
+        {
+            continue;
+        }
+        ++m_received;
+
+        switch (header.GetType())
+        {
+        case PimDmHeader::HELLO:
+            m_neighbors[interface][source] = Simulator::Now() + Seconds(header.GetHoldTime());
+            break;
+        case PimDmHeader::JOIN_PRUNE:
+            HandleJoinPrune(interface, source, header);
+            break;
+        case PimDmHeader::GRAFT:
+            HandleGraft(interface, source, header);
+            break;
+        case PimDmHeader::GRAFT_ACK:
+            if (IsLocalAddress(interface, header.GetUpstream()))
+            {
+                auto it = m_entries.find({header.GetSource(), header.GetGroup()});
+                if (it != m_entries.end())
+                {
+                    it->second.graftPending = false;
+                    Simulator::Cancel(it->second.graftRetry);
+                }
+            }
+            break;
+        }
+    }
+}
+
+void
+PimDmRouting::HandleJoinPrune(uint32_t interface, Ipv4Address from, const PimDmHeader& header)
+{
+    Key key{header.GetSource(), header.GetGroup()};
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+    {
+        return;
+    }
+    Entry& entry = it->second;
+
+    if (!IsLocalAddress(interface, header.GetUpstream()))
+    {
+        // Overheard on a multi-access link: a Prune sent to our own RPF
+        // neighbor would cut us off as well, so override it with a Join.
+        if (header.IsPrune() && entry.iif == interface && entry.upstream == header.GetUpstream() &&
+            WantsTraffic(entry))
+        {
+            SendJoinPrune(interface, entry.upstream, entry, false);
+            ++m_pruneOverrides;
+        }
+        return;
+    }
+
+    if (!header.IsPrune())
+    {
+        Simulator::Cancel(entry.pendingPrunes[interface]);
+        entry.pendingPrunes.erase(interface);
+        entry.prunedUntil.erase(interface);
+        return;
+    }
+
+    Time holdTime = Seconds(header.GetHoldTime());
+    if (NeighborCount(interface) > 1)
+    {
+        if (entry.pendingPrunes[interface].IsExpired())
+        {
+            entry.pendingPrunes[interface] = Simulator::Schedule(m_overrideInterval,
+                                                                 &PimDmRouting::ApplyPrune,
+                                                                 this,
+                                                                 key,
+                                                                 interface,
+                                                                 holdTime);
+        }
+        return;
+    }
+    ApplyPrune(key, interface, holdTime);
+}
+
+void
+PimDmRouting::HandleGraft(uint32_t interface, Ipv4Address from, const PimDmHeader& header)
+{
+    if (!IsLocalAddress(interface, header.GetUpstream()))
+    {
+        return;
+    }
+
+    PimDmHeader ack(PimDmHeader::GRAFT_ACK);
+    ack.SetUpstream(from);
+    ack.SetGroup(header.GetGroup());
+    ack.SetSource(header.GetSource());
+    Send(interface, ack);
+
+    auto it = m_entries.find({header.GetSource(), header.GetGroup()});
+    if (it == m_entries.end())
+    {
+        return;
+    }
+    Entry& entry = it->second;
+    Simulator::Cancel(entry.pendingPrunes[interface]);
+    entry.pendingPrunes.erase(interface);
+    entry.prunedUntil.erase(interface);
+    if (entry.upstreamPruned)
+    {
+        Graft(entry);
+    }
+}
+
+void
+PimDmRouting::ApplyPrune(Key key, uint32_t interface, Time holdTime)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+    {
+        return;
+    }
+    Entry& entry = it->second;
+    entry.pendingPrunes.erase(interface);
+    entry.prunedUntil[interface] = Simulator::Now() + holdTime;
+    if (!WantsTraffic(entry))
+    {
+        PruneUpstream(entry);
+    }
+}
+
+PimDmRouting::Entry*
+PimDmRouting::GetEntry(Ipv4Address source, Ipv4Address group)
+{
+    Key key{source, group};
+    auto it = m_entries.find(key);
+    if (it != m_entries.end())
+    {
+        return &it->second;
+    }
+
+    // RPF: the interface and next hop unicast routing uses towards the source.
+    Ipv4Header header;
+    header.SetDestination(source);
+    Socket::SocketErrno error;
+    Ptr<Ipv4Route> route =
+        m_ipv4->GetRoutingProtocol()->RouteOutput(nullptr, header, nullptr, error);
+    if (!route)
+    {
+        return nullptr;
+    }
+
+    Entry entry;
+    entry.source = source;
+    entry.group = group;
+    entry.iif = m_ipv4->GetInterfaceForDevice(route->GetOutputDevice());
+    entry.upstream =
+        route->GetGateway() == Ipv4Address::GetZero() ? source : route->GetGateway();
+    return &m_entries.emplace(key, entry).first->second;
+}
+
+bool
+PimDmRouting::IsNeighbor(uint32_t interface, Ipv4Address address) const
+{
+    auto it = m_neighbors.find(interface);
+    if (it == m_neighbors.end())
+    {
+        return false;
+    }
+    auto neighbor = it->second.find(address);
+    return neighbor != it->second.end() && neighbor->second > Simulator::Now();
+}
+
+uint32_t
+PimDmRouting::NeighborCount(uint32_t interface) const
+{
+    auto it = m_neighbors.find(interface);
+    if (it == m_neighbors.end())
+    {
+        return 0;
+    }
+
+    Time now = Simulator::Now();
+    uint32_t count = 0;
+    for (auto& [address, expires] : it->second)
+    {
+        count += expires > now;
+    }
+    return count;
+}
+
+bool
+PimDmRouting::IsLocalAddress(uint32_t interface, Ipv4Address address) const
+{
+    for (uint32_t i = 0; i < m_ipv4->GetNAddresses(interface); ++i)
+    {
+        if (m_ipv4->GetAddress(interface, i).GetLocal() == address)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<uint32_t>
+PimDmRouting::OutgoingInterfaces(const Entry& entry) const
+{
+    Time now = Simulator::Now();
+    std::vector<uint32_t> interfaces;
+    for (uint32_t i = 1; i < m_ipv4->GetNInterfaces(); ++i)
+    {
+        if (i == entry.iif || !m_ipv4->IsUp(i))
+        {
+            continue;
+        }
+
+        if (m_members.count({i, entry.group}))
+        {
+            interfaces.push_back(i);
+            continue;
+        }
+
+        auto pruned = entry.prunedUntil.find(i);
+        if (NeighborCount(i) > 0 && (pruned == entry.prunedUntil.end() || pruned->second <= now))
+        {
+            interfaces.push_back(i);
+        }
+    }
+    return interfaces;
+}
+
+bool
+PimDmRouting::WantsTraffic(const Entry& entry) const
+{
+    return m_localMembers.count(entry.group) || !OutgoingInterfaces(entry).empty();
+}
+
+void
+PimDmRouting::PruneUpstream(Entry& entry)
+{
+    Time now = Simulator::Now();
+    if (!IsNeighbor(entry.iif, entry.upstream) || now < entry.pruneLimit)
+    {
+        return;
+    }
+
+    SendJoinPrune(entry.iif, entry.upstream, entry, true);
+    entry.upstreamPruned = true;
+    entry.pruneLimit = now + m_pruneLimitInterval;
+    entry.graftPending = false;
+    Simulator::Cancel(entry.graftRetry);
+}
+
+void
+PimDmRouting::Graft(Entry& entry)
+{
+    entry.upstreamPruned = false;
+    entry.pruneLimit = Time(0);
+    if (!IsNeighbor(entry.iif, entry.upstream))
+    {
+        return;
+    }
+
+    PimDmHeader graft(PimDmHeader::GRAFT);
+    graft.SetUpstream(entry.upstream);
+    graft.SetGroup(entry.group);
+    graft.SetSource(entry.source);
+    Send(entry.iif, graft);
+
+    entry.graftPending = true;
+    Simulator::Cancel(entry.graftRetry);
+    entry.graftRetry = Simulator::Schedule(m_graftRetryInterval,
+                                           &PimDmRouting::RetryGraft,
+                                           this,
+                                           Key{entry.source, entry.group});
+}
+
+void
+PimDmRouting::RetryGraft(Key key)
+{
+    auto it = m_entries.find(key);
+    if (it != m_entries.end() && it->second.graftPending)
+    {
+        Graft(it->second);
+    }
+}
+
+void
+PimDmRouting::MembershipAdded(Ipv4Address group)
+{
+    for (auto& [key, entry] : m_entries)
+    {
+        if (entry.group == group && entry.upstreamPruned && WantsTraffic(entry))
+        {
+            Graft(entry);
+        }
+    }
+}
@@ -0,0 +1,132 @@
+#include "queue-monitor.h"
+
+#include <ns3/callback.h>
+#include <ns3/fatal-error.h>
+#include <ns3/nstime.h>
+#include <ns3/ptr.h>
+#include <ns3/queue-disc.h>
+#include <ns3/simulator.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <ios>
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+void
+QueueMonitor::Install(const std::string& label, Ptr<QueueDisc> disc, Time interval)
+{
+    Series& series = m_series[label];
+    series.disc = disc;
+    series.interval = interval;
+    series.samples.reserve(1024);
+
+    disc->TraceConnectWithoutContext("SojournTime",
+                                     MakeBoundCallback(&QueueMonitor::Sojourn, &series));
+    Simulator::Schedule(interval, &QueueMonitor::Sample, &series);
+}
+
+void
+QueueMonitor::Sojourn(Series* series, Time sojourn)
+{
+    double seconds = sojourn.GetSeconds();
+    series->sojournSum += seconds;
+    series->sojournMax = std::max(series->sojournMax, seconds);
+    ++series->sojournCount;
+    series->totalSojourn += seconds;
+    ++series->totalDequeued;
+}
+
+void
+QueueMonitor::Sample(Series* series)
+{
+    double mean = series->sojournCount ? series->sojournSum / series->sojournCount : 0.0;
+    series->samples.push_back(QueueSample{Simulator::Now().GetSeconds(),
+                                          series->disc->GetNPackets(),
+                                          series->disc->GetNBytes(),
+                                          mean,
+                                          series->sojournMax});
+
+    series->sojournSum = 0;
+    series->sojournMax = 0;
+    series->sojournCount = 0;
+
+    Simulator::Schedule(series->interval, &QueueMonitor::Sample, series);
+}
+
+QueueMonitor::Summary
+QueueMonitor::Summarize(const Series& series)
+{
+    Summary summary{0, 0, 0, 0};
+    for (auto& s : series.samples)
+    {
+        summary.depthMean += s.packets;
+        summary.depthMax = std::max(summary.depthMax, s.packets);
+        summary.sojournMax = std::max(summary.sojournMax, s.sojournMax);
+    }
+    summary.depthMean /= std::max<size_t>(series.samples.size(), 1);
+    summary.sojournMean = series.totalDequeued ? series.totalSojourn / series.totalDequeued : 0.0;
+    return summary;
+}
+
+void
+QueueMonitor::Report() const
+{
+    if (m_series.empty())
+    {
+        return;
+    }
+
+    std::cout << "queue report" << std::endl;
+    std::ios format(nullptr);
+    format.copyfmt(std::cout);
+    for (auto& [label, series] : m_series)
+    {
+        Summary summary = Summarize(series);
+
+        std::cout << "  " << label << ": " << series.samples.size() << " samples, depth mean "
+                  << std::fixed << std::setprecision(2) << summary.depthMean << " max "
+                  << summary.depthMax << " packets, sojourn mean " << summary.sojournMean * 1000
+                  << " max " << summary.sojournMax * 1000 << " ms, "
+                  << series.disc->GetStats().nTotalDroppedPackets << " drops" << std::endl;
+    }
+    std::cout.copyfmt(format);
+}
+
+void
+QueueMonitor::Record(ResultStore& store) const
+{
+    for (auto& [label, series] : m_series)
+    {
+        Summary summary = Summarize(series);
+        store.AddMetric("queue", label, "depth_mean", summary.depthMean);
+        store.AddMetric("queue", label, "depth_max", summary.depthMax);
+        store.AddMetric("queue", label, "sojourn_mean", summary.sojournMean);
+        store.AddMetric("queue", label, "sojourn_max", summary.sojournMax);
+        store.AddMetric("queue", label, "drops", series.disc->GetStats().nTotalDroppedPackets);
+    }
+}
+
+void
+QueueMonitor::Write(const std::string& filename) const
+{
+    std::ofstream out(filename);
+    if (!out)
+    {
+        NS_FATAL_ERROR("Failed to open queue log: " << filename);
+    }
+
+    out << "queue,time,packets,bytes,sojourn_mean,sojourn_max\n";
+    for (auto& [label, series] : m_series)
+    {
+        for (auto& s : series.samples)
+        {
+            out << label << ',' << s.time << ',' << s.packets << ',' << s.bytes << ','
+                << s.sojournMean << ',' << s.sojournMax << '\n';
+        }
+    }
+}
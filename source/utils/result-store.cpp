@@ -0,0 +1,231 @@
+#include "result-store.h"
+
+#include <ns3/fatal-error.h>
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <iomanip>
+#include <sqlite3.h>
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+const char* kSchema = R"(
+CREATE TABLE IF NOT EXISTS runs (
+    id INTEGER PRIMARY KEY,
+    config TEXT,
+    config_hash TEXT,
+    started TEXT,
+    wall_seconds REAL,
+    sim_seconds REAL
+);
+CREATE TABLE IF NOT EXISTS parameters (
+    run_id INTEGER REFERENCES runs(id),
+    key TEXT,
+    value TEXT
+);
+CREATE TABLE IF NOT EXISTS metrics (
+    run_id INTEGER REFERENCES runs(id),
+    kind TEXT,
+    entity TEXT,
+    metric TEXT,
+    value REAL
+);
+CREATE TABLE IF NOT EXISTS timings (
+    run_id INTEGER REFERENCES runs(id),
+    phase TEXT,
+    seconds REAL
+);
+CREATE INDEX IF NOT EXISTS parameters_run ON parameters(run_id);
+CREATE INDEX IF NOT EXISTS metrics_run ON metrics(run_id);
+CREATE INDEX IF NOT EXISTS metrics_lookup ON metrics(kind, metric);
+)";
+
+// Prepared statement that finalizes itself on every return path.
+class Statement
+{
+  public:
+    Statement(sqlite3* db, const char* sql)
+    {
+        if (sqlite3_prepare_v2(db, sql, -1, &m_stmt, nullptr) != SQLITE_OK)
+        {
+            NS_FATAL_ERROR("Failed to prepare statement: " << sqlite3_errmsg(db));
+        }
+    }
+
+    ~Statement()
+    {
+        sqlite3_finalize(m_stmt);
+    }
+
+    Statement& Bind(int index, const std::string& value)
+    {
+        sqlite3_bind_text(m_stmt, index, value.c_str(), -1, SQLITE_TRANSIENT);
+        return *this;
+    }
+
+    Statement& Bind(int index, double value)
+    {
+        sqlite3_bind_double(m_stmt, index, value);
+        return *this;
+    }
+
+    Statement& Bind(int index, int64_t value)
+    {
+        sqlite3_bind_int64(m_stmt, index, value);
+        return *this;
+    }
+
+    void Step(sqlite3* db)
+    {
+        if (sqlite3_step(m_stmt) != SQLITE_DONE)
+        {
+            NS_FATAL_ERROR("Failed to write results: " << sqlite3_errmsg(db));
+        }
+        sqlite3_reset(m_stmt);
+    }
+
+  private:
+    sqlite3_stmt* m_stmt = nullptr;
+};
+
+} // namespace
+
+ResultStore::~ResultStore()
+{
+    if (m_db)
+    {
+        sqlite3_close(m_db);
+    }
+}
+
+void
+ResultStore::Open(const std::string& path)
+{
+    if (sqlite3_open(path.c_str(), &m_db) != SQLITE_OK)
+    {
+        std::string error = m_db ? sqlite3_errmsg(m_db) : "out of memory";
+        sqlite3_close(m_db);
+        m_db = nullptr;
+        NS_FATAL_ERROR("Failed to open result store " << path << ": " << error);
+    }
+
+    // Parallel sweeps commit to the same file; wait for the lock rather than
+    // failing, and let WAL keep readers out of the writers' way.
+    sqlite3_busy_timeout(m_db, 60000);
+    Execute("PRAGMA journal_mode=WAL;");
+    Execute("PRAGMA synchronous=NORMAL;");
+    Execute(kSchema);
+}
+
+void
+ResultStore::BeginRun(const std::string& config, const std::string& text)
+{
+    std::ostringstream hash;
+    hash << std::hex << std::setw(16) << std::setfill('0') << Hash(text);
+
+    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::ostringstream started;
+    started << std::put_time(std::gmtime(&now), "%Y-%m-%dT%H:%M:%SZ");
+
+    m_config = config;
+    m_configHash = hash.str();
+    m_started = started.str();
+    m_parameters.clear();
+    m_metrics.clear();
+    m_timings.clear();
+}
+
+void
+ResultStore::AddParameter(const std::string& key, const std::string& value)
+{
+    m_parameters.emplace_back(key, value);
+}
+
+void
+ResultStore::AddMetric(const std::string& kind,
+                       const std::string& entity,
+                       const std::string& metric,
+                       double value)
+{
+    m_metrics.push_back(Metric{kind, entity, metric, value});
+}
+
+void
+ResultStore::AddTiming(const std::string& phase, double seconds)
+{
+    m_timings.emplace_back(phase, seconds);
+}
+
+void
+ResultStore::Commit(double wallSeconds, double simSeconds)
+{
+    if (!m_db)
+    {
+        return;
+    }
+
+    Execute("BEGIN IMMEDIATE;");
+
+    Statement run(m_db,
+                  "INSERT INTO runs (config, config_hash, started, wall_seconds, sim_seconds) "
+                  "VALUES (?, ?, ?, ?, ?);");
+    run.Bind(1, m_config).Bind(2, m_configHash).Bind(3, m_started);
+    run.Bind(4, wallSeconds).Bind(5, simSeconds).Step(m_db);
+    int64_t id = sqlite3_last_insert_rowid(m_db);
+
+    Statement parameter(m_db, "INSERT INTO parameters (run_id, key, value) VALUES (?, ?, ?);");
+    for (auto& [key, value] : m_parameters)
+    {
+        parameter.Bind(1, id).Bind(2, key).Bind(3, value).Step(m_db);
+    }
+
+    Statement metric(m_db,
+                     "INSERT INTO metrics (run_id, kind, entity, metric, value) "
+                     "VALUES (?, ?, ?, ?, ?);");
+    for (auto& m : m_metrics)
+    {
+        metric.Bind(1, id).Bind(2, m.kind).Bind(3, m.entity).Bind(4, m.metric);
+        metric.Bind(5, m.value).Step(m_db);
+    }
+
+    Statement timing(m_db, "INSERT INTO timings (run_id, phase, seconds) VALUES (?, ?, ?);");
+    for (auto& [phase, seconds] : m_timings)
+    {
+        timing.Bind(1, id).Bind(2, phase).Bind(3, seconds).Step(m_db);
+    }
+
+    Execute("COMMIT;");
+
+    m_parameters.clear();
+    m_metrics.clear();
+    m_timings.clear();
+}
+
+uint64_t
+ResultStore::Hash(const std::string& text)
+{
+    // 64-bit FNV-1a; only used to group runs of identical configurations.
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void
+ResultStore::Execute(const char* sql)
+{
+    char* error = nullptr;
+    if (sqlite3_exec(m_db, sql, nullptr, nullptr, &error) != SQLITE_OK)
+    {
+        std::string message = error ? error : "unknown error";
+        sqlite3_free(error);
+        NS_FATAL_ERROR("Result store error: " << message);
+    }
+}
@@ -1,6 +1,11 @@
 #include "setup.h"
 
 #include "basic-amt.h"
+#include "load-generator.h"
+#include "multicast-to-unicast-queue-disc.h"
+#include "pim-dm-routing.h"
+#include "result-store.h"
+#include "trace-replay.h"
 
 #include <ns3/application-container.h>
 #include <ns3/assert.h>
@@ -8,16 +13,24 @@
 #include <ns3/channel.h>
 #include <ns3/config.h>
 #include <ns3/csma-helper.h>
+#include <ns3/data-rate.h>
+#include <ns3/double.h>
 #include <ns3/fatal-error.h>
 #include <ns3/internet-stack-helper.h>
 #include <ns3/ipv4-address-helper.h>
 #include <ns3/ipv4-address.h>
+#include <ns3/ipv4-header.h>
 #include <ns3/ipv4-global-routing-helper.h>
 #include <ns3/ipv4-interface-container.h>
+#include <ns3/ipv4-list-routing.h>
+#include <ns3/ipv4-route.h>
+#include <ns3/ipv4-routing-protocol.h>
 #include <ns3/ipv4-static-routing-helper.h>
 #include <ns3/ipv4-static-routing.h>
 #include <ns3/ipv4.h>
 #include <ns3/log.h>
+#include <ns3/mac48-address.h>
+#include <ns3/mobility-helper.h>
 #include <ns3/names.h>
 #include <ns3/net-device-container.h>
 #include <ns3/net-device.h>
@@ -28,12 +41,32 @@
 #include <ns3/object.h>
 #include <ns3/on-off-helper.h>
 #include <ns3/packet-sink-helper.h>
+#include <ns3/packet-sink.h>
+#include <ns3/position-allocator.h>
+#include <ns3/queue-disc-container.h>
+#include <ns3/queue-disc.h>
+#include <ns3/queue-size.h>
 #include <ns3/ptr.h>
 #include <ns3/simulator.h>
+#include <ns3/socket.h>
+#include <ns3/ssid.h>
 #include <ns3/string.h>
+#include <ns3/traffic-control-helper.h>
+#include <ns3/traffic-control-layer.h>
 #include <ns3/udp-l4-protocol.h>
+#include <ns3/uinteger.h>
+#include <ns3/vector.h>
+#include <ns3/wifi-helper.h>
+#include <ns3/wifi-mac-helper.h>
+#include <ns3/wifi-net-device.h>
+#include <ns3/yans-wifi-helper.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -44,13 +77,92 @@
 
 using namespace ns3;
 
+namespace
+{
+
+std::string
+QueueDiscTypeId(const std::string& type)
+{
+    static const std::unordered_map<std::string, std::string> types{
+        {"fifo", "ns3::FifoQueueDisc"},
+        {"pfifo-fast", "ns3::PfifoFastQueueDisc"},
+        {"codel", "ns3::CoDelQueueDisc"},
+        {"fq-codel", "ns3::FqCoDelQueueDisc"},
+        {"red", "ns3::RedQueueDisc"},
+        {"pie", "ns3::PieQueueDisc"},
+    };
+
+    auto it = types.find(type);
+    if (it != types.end())
+    {
+        return it->second;
+    }
+    if (type.rfind("ns3::", 0) == 0)
+    {
+        return type;
+    }
+    NS_FATAL_ERROR("Unknown queue disc type: " << type);
+    return {};
+}
+
+// Records every scalar in the configuration under its dotted path, with
+// sequence elements keyed by position (links.2.queue.type).
+void
+FlattenParameters(const YAML::Node& node, const std::string& prefix, ResultStore& store)
+{
+    if (node.IsScalar())
+    {
+        store.AddParameter(prefix, node.as<std::string>());
+    }
+    else if (node.IsSequence())
+    {
+        for (size_t i = 0; i < node.size(); ++i)
+        {
+            FlattenParameters(node[i], prefix + "." + std::to_string(i), store);
+        }
+    }
+    else if (node.IsMap())
+    {
+        for (auto it = node.begin(); it != node.end(); ++it)
+        {
+            auto key = it->first.as<std::string>();
+            FlattenParameters(it->second, prefix.empty() ? key : prefix + "." + key, store);
+        }
+    }
+}
+
+double
+SecondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration<double>(to - from).count();
+}
+
+} // namespace
+
 Topology::Topology(std::string& filename)
+    : m_wallStart(std::chrono::steady_clock::now())
 {
     std::cout << "parsing yaml: " << filename << std::endl;
     YAML::Node config = YAML::LoadFile(filename);
 
+    if (config["results"])
+    {
+        std::ifstream file(filename);
+        std::stringstream text;
+        text << file.rdbuf();
+
+        m_results.Open(config["results"].as<std::string>());
+        m_results.BeginRun(filename, text.str());
+        FlattenParameters(config, "", m_results);
+    }
+
     Config::SetDefault("ns3::CsmaNetDevice::EncapsulationMode", StringValue("Dix"));
 
+    if (config["pcap"])
+    {
+        m_pcap = config["pcap"].as<std::string>();
+    }
+
     NodeContainer nodes;
     std::unordered_map<std::string, Ptr<Node>> nodeMap;
 
@@ -65,8 +177,9 @@ Topology::Topology(std::string& filename)
         Names::Add(name, node);
     }
 
+    DataRate linkRate("100Mbps");
     CsmaHelper csma;
-    csma.SetChannelAttribute("DataRate", StringValue("100Mbps"));
+    csma.SetChannelAttribute("DataRate", DataRateValue(linkRate));
     csma.SetChannelAttribute("Delay", TimeValue(MilliSeconds(1)));
 
     InternetStackHelper internet;
@@ -90,12 +203,78 @@ Topology::Topology(std::string& filename)
             link.Add(nodeMap[m]);
         }
 
-        NetDeviceContainer devices = csma.Install(link);
+        auto type = l["type"] ? l["type"].as<std::string>() : "csma";
+
+        NetDeviceContainer devices;
+        if (type == "csma")
+        {
+            devices = csma.Install(link);
+        }
+        else if (type == "wifi")
+        {
+            devices = InstallWifi(l, name, link);
+        }
+        else
+        {
+            NS_FATAL_ERROR("Unknown link type: " << type);
+        }
+
+        if (l["mtu"])
+        {
+            auto mtu = l["mtu"].as<uint16_t>();
+            for (uint32_t i = 0; i < devices.GetN(); ++i)
+            {
+                devices.Get(i)->SetMtu(mtu);
+            }
+        }
+
+        // Queue discs must be in place before addresses are assigned, or the
+        // address helper installs its default one.
+        if (l["queue"])
+        {
+            auto q = l["queue"];
+            std::string discType = QueueDiscTypeId(q["type"].as<std::string>());
+
+            TrafficControlHelper tch;
+            if (q["size"])
+            {
+                auto size = q["size"].as<std::string>();
+                tch.SetRootQueueDisc(discType, "MaxSize", QueueSizeValue(QueueSize(size)));
+            }
+            else
+            {
+                tch.SetRootQueueDisc(discType);
+            }
+
+            for (uint32_t i = 0; i < devices.GetN(); ++i)
+            {
+                // A converting Wi-Fi AP already has its own root queue disc.
+                Ptr<NetDevice> device = devices.Get(i);
+                auto tc = link.Get(i)->GetObject<TrafficControlLayer>();
+                Ptr<QueueDisc> disc = tc->GetRootQueueDiscOnDevice(device);
+                if (!disc)
+                {
+                    disc = tch.Install(device).Get(0);
+                }
+
+                if (q["sample"])
+                {
+                    std::string neighbor = Names::FindName(link.Get(i));
+                    m_queueMonitor.Install(neighbor + "-" + name,
+                                           disc,
+                                           Seconds(q["sample"].as<double>()));
+                }
+            }
+        }
 
         ipv4.SetBase(subnet.c_str(), mask.c_str());
         auto interface = ipv4.Assign(devices);
 
         linkMap[name] = Link{subnet, devices, interface};
+        if (type == "csma")
+        {
+            m_linkMonitor.Install(name, devices, linkRate);
+        }
 
         for (uint32_t i = 0; i < devices.GetN(); ++i)
         {
@@ -122,6 +301,24 @@ Topology::Topology(std::string& filename)
     {
         m_mcSource = config["multicast"]["source"].as<std::string>();
         m_mcGroup = config["multicast"]["group"].as<std::string>();
+        m_mcProtocol = config["multicast"]["protocol"]
+                           ? config["multicast"]["protocol"].as<std::string>()
+                           : "static";
+        if (m_mcProtocol != "static" && m_mcProtocol != "dense")
+        {
+            NS_FATAL_ERROR("Unknown multicast protocol: " << m_mcProtocol);
+        }
+        m_mcGroups.push_back(m_mcGroup);
+        if (config["multicast"]["groups"])
+        {
+            for (auto& g : config["multicast"]["groups"].as<std::vector<std::string>>())
+            {
+                if (g != m_mcGroup)
+                {
+                    m_mcGroups.push_back(g);
+                }
+            }
+        }
 
         for (auto r : config["multicast"]["routes"])
         {
@@ -192,11 +389,73 @@ Topology::Topology(std::string& filename)
             {
                 app.link = a["link"].as<std::string>();
             }
+            if (a["mtu"])
+            {
+                app.mtu = a["mtu"].as<uint32_t>();
+            }
+            if (a["dropOversize"])
+            {
+                app.dropOversize = a["dropOversize"].as<bool>();
+            }
             // For Gateway
             if (a["relay"])
             {
                 app.relay = a["relay"].as<std::string>();
             }
+            if (a["relays"])
+            {
+                app.relays = a["relays"].as<std::vector<std::string>>();
+            }
+            if (a["selection"])
+            {
+                app.selection = a["selection"].as<std::string>();
+            }
+            if (a["stall"])
+            {
+                app.stall = a["stall"].as<double>();
+            }
+            // For TraceReplay
+            if (a["trace"])
+            {
+                app.trace = a["trace"].as<std::string>();
+            }
+            if (a["loop"])
+            {
+                app.loop = a["loop"].as<bool>();
+            }
+            // For LoadGen
+            if (a["model"])
+            {
+                app.model = a["model"].as<std::string>();
+            }
+            if (a["sources"])
+            {
+                app.sources = a["sources"].as<uint32_t>();
+            }
+            if (a["groups"])
+            {
+                app.groups = a["groups"].as<std::vector<std::string>>();
+            }
+            if (a["fps"])
+            {
+                app.fps = a["fps"].as<double>();
+            }
+            if (a["gop"])
+            {
+                app.gop = a["gop"].as<uint32_t>();
+            }
+            if (a["spread"])
+            {
+                app.spread = a["spread"].as<double>();
+            }
+            if (a["onTime"])
+            {
+                app.onTime = a["onTime"].as<double>();
+            }
+            if (a["offTime"])
+            {
+                app.offTime = a["offTime"].as<double>();
+            }
             m_apps.push_back(app);
         }
     }
@@ -219,9 +478,24 @@ Topology::Topology(std::string& filename)
             break;
         }
     }
+    m_mcSourceAddress = sourceAddr;
+
+    bool dense = m_mcProtocol == "dense";
+    if (dense)
+    {
+        InstallPimDm();
+    }
 
     for (auto& route : m_mcRoutes)
     {
+        // In dense mode the protocol builds the trees. Only the default
+        // route of a source on a router is kept; single-homed nodes already
+        // have one.
+        if (dense && (!route.inner.empty() || !m_pimRouters.count(route.node)))
+        {
+            continue;
+        }
+
         Ptr<Node> node = GetNode(route.node);
         Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
         Ptr<Ipv4StaticRouting> rt = multicast.GetStaticRouting(ipv4);
@@ -244,9 +518,13 @@ Topology::Topology(std::string& filename)
                 interfaces.push_back(FindInterfaceIndex(node, out));
             }
 
-            Simulator::Schedule(Seconds(12), [sourceAddr, multicastGroup, index, interfaces, rt]() {
-                rt->AddMulticastRoute(sourceAddr, multicastGroup, index, interfaces);
-            });
+            for (auto& g : m_mcGroups)
+            {
+                Ipv4Address group(g.c_str());
+                Simulator::Schedule(Seconds(12), [sourceAddr, group, index, interfaces, rt]() {
+                    rt->AddMulticastRoute(sourceAddr, group, index, interfaces);
+                });
+            }
         }
     }
     std::cout << "application setting" << std::endl;
@@ -264,34 +542,118 @@ Topology::Topology(std::string& filename)
             onoff.SetConstantRate(DataRate(app.rate));
             onoff.SetAttribute("PacketSize", UintegerValue(app.packetSize));
 
-            ApplicationContainer container = onoff.Install(n);
+            container = onoff.Install(n);
         }
         else if (app.type == "PacketSink")
         {
             PacketSinkHelper sink("ns3::UdpSocketFactory",
                                   Address(InetSocketAddress(Ipv4Address::GetAny(), app.port)));
             container = sink.Install(n);
+            auto sinkApp = DynamicCast<PacketSink>(container.Get(0));
+            sinkApp->TraceConnectWithoutContext(
+                "Rx",
+                MakeBoundCallback(&Topology::SinkRx, &m_sinkFirstRx, app.node));
+            m_sinkApps.emplace_back(app.node, sinkApp);
+            ScheduleMembership(n, m_mcGroups, app.start, app.stop);
         }
         else if (app.type == "Relay")
         {
             ObjectFactory factory;
             factory.SetTypeId("RelayApp");
+            factory.Set("Mtu", UintegerValue(app.mtu));
+            factory.Set("DropOversize", BooleanValue(app.dropOversize));
             Ptr<RelayApp> relayApp = factory.Create<RelayApp>();
+            relayApp->SetRelayAddress(GetNodeAddress(n));
+            relayApp->SetPathMtuCallback(
+                [this, n](Ipv4Address gateway) { return PathMtu(n, gateway); });
+            m_linkMonitor.AddAmtPort(2268);
 
-            Ptr<Node> gatewayNode = GetNode(app.gateway);
-            Ipv4Address gatewayAddr = GetAddressOnLink(gatewayNode, app.link);
-            relayApp->Setup(gatewayAddr, app.unicast, multicastGroup, app.port);
+            if (app.gateway.empty())
+            {
+                relayApp->Setup(multicastGroup, app.port);
+            }
+            else
+            {
+                Ptr<Node> gatewayNode = GetNode(app.gateway);
+                Ipv4Address gatewayAddr = GetAddressOnLink(gatewayNode, app.link);
+                relayApp->Setup(gatewayAddr, app.unicast, multicastGroup, app.port);
+                m_linkMonitor.AddAmtPort(app.unicast);
+            }
             n->AddApplication(relayApp);
             container.Add(relayApp);
+            m_relayApps.emplace_back(app.node, relayApp);
+            ScheduleMembership(n, {m_mcGroup}, app.start, app.stop);
         }
         else if (app.type == "Gateway")
         {
             ObjectFactory factory;
             factory.SetTypeId("GatewayApp");
+            if (!app.selection.empty())
+            {
+                factory.Set("Selection", StringValue(app.selection));
+            }
+            factory.Set("StallTimeout", TimeValue(Seconds(app.stall)));
             Ptr<GatewayApp> gatewayApp = factory.Create<GatewayApp>();
             gatewayApp->Setup(app.unicast);
+            m_linkMonitor.AddAmtPort(app.unicast);
+            m_linkMonitor.AddAmtPort(2268);
+
+            if (!app.relays.empty())
+            {
+                std::vector<Ipv4Address> relays;
+                for (auto& r : app.relays)
+                {
+                    relays.push_back(GetNodeAddress(GetNode(r)));
+                }
+                gatewayApp->SetRelays(relays, 2268);
+            }
             n->AddApplication(gatewayApp);
             container.Add(gatewayApp);
+            m_gatewayApps.emplace_back(app.node, gatewayApp);
+        }
+        else if (app.type == "LoadGen")
+        {
+            ObjectFactory factory;
+            factory.SetTypeId("LoadGeneratorApp");
+            factory.Set("FrameRate", DoubleValue(app.fps));
+            factory.Set("GopLength", UintegerValue(app.gop));
+            factory.Set("FrameSpread", DoubleValue(app.spread));
+            factory.Set("OnTime", TimeValue(Seconds(app.onTime)));
+            factory.Set("OffTime", TimeValue(Seconds(app.offTime)));
+            Ptr<LoadGeneratorApp> loadApp = factory.Create<LoadGeneratorApp>();
+
+            std::vector<Ipv4Address> groups;
+            if (app.groups.empty())
+            {
+                groups.emplace_back(app.target.c_str());
+            }
+            for (auto& g : app.groups)
+            {
+                groups.emplace_back(g.c_str());
+            }
+
+            loadApp->Setup(LoadGeneratorApp::ParseModel(app.model),
+                           groups,
+                           app.port,
+                           app.sources,
+                           DataRate(app.rate),
+                           app.packetSize);
+            n->AddApplication(loadApp);
+            container.Add(loadApp);
+            m_loadApps.emplace_back(app.node, loadApp);
+        }
+        else if (app.type == "TraceReplay")
+        {
+            ObjectFactory factory;
+            factory.SetTypeId("TraceReplayApp");
+            factory.Set("Loop", BooleanValue(app.loop));
+            Ptr<TraceReplayApp> replayApp = factory.Create<TraceReplayApp>();
+
+            Ipv4Address group(app.target.c_str());
+            replayApp->Setup(app.trace, group, app.port);
+            n->AddApplication(replayApp);
+            container.Add(replayApp);
+            m_replayApps.emplace_back(app.node, replayApp);
         }
         else
         {
@@ -302,11 +664,104 @@ Topology::Topology(std::string& filename)
         container.Stop(Seconds(app.stop));
     }
 
-    if (config["pcap"])
+    if (config["queueLog"])
+    {
+        m_queueLog = config["queueLog"].as<std::string>();
+    }
+
+    if (!m_pcap.empty())
     {
-        m_pcap = config["pcap"].as<std::string>();
         csma.EnablePcapAll(m_pcap);
     }
+
+    m_setupEnd = std::chrono::steady_clock::now();
+}
+
+NetDeviceContainer
+Topology::InstallWifi(const YAML::Node& l, const std::string& name, const NodeContainer& link)
+{
+    if (link.GetN() < 2)
+    {
+        NS_FATAL_ERROR("Wi-Fi link " << name << " needs an access point and at least one station");
+    }
+
+    // The first member is the access point, the rest associate to it. Rates
+    // are 802.11a OFDM mode names; group addressed frames go out at the
+    // multicast rate unless the AP converts them to unicast.
+    auto dataMode = l["rate"] ? l["rate"].as<std::string>() : "OfdmRate54Mbps";
+    auto multicastMode =
+        l["multicastRate"] ? l["multicastRate"].as<std::string>() : "OfdmRate6Mbps";
+    bool conversion = l["conversion"] && l["conversion"].as<bool>();
+    double distance = l["distance"] ? l["distance"].as<double>() : 10.0;
+
+    NodeContainer ap(link.Get(0));
+    NodeContainer stations;
+    for (uint32_t i = 1; i < link.GetN(); ++i)
+    {
+        stations.Add(link.Get(i));
+    }
+
+    YansWifiChannelHelper channel = YansWifiChannelHelper::Default();
+    YansWifiPhyHelper phy;
+    phy.SetChannel(channel.Create());
+
+    WifiHelper wifi;
+    wifi.SetStandard(WIFI_STANDARD_80211a);
+    wifi.SetRemoteStationManager("ns3::ConstantRateWifiManager",
+                                 "DataMode",
+                                 StringValue(dataMode),
+                                 "ControlMode",
+                                 StringValue("OfdmRate6Mbps"),
+                                 "NonUnicastMode",
+                                 StringValue(multicastMode));
+
+    Ssid ssid(name);
+    WifiMacHelper mac;
+    mac.SetType("ns3::ApWifiMac", "Ssid", SsidValue(ssid));
+    NetDeviceContainer devices = wifi.Install(phy, mac, ap);
+    mac.SetType("ns3::StaWifiMac", "Ssid", SsidValue(ssid));
+    devices.Add(wifi.Install(phy, mac, stations));
+
+    // Stations sit on a circle around the AP so every one sees the same
+    // path loss and the rate settings alone decide the airtime.
+    auto positions = CreateObject<ListPositionAllocator>();
+    positions->Add(Vector(0, 0, 0));
+    for (uint32_t i = 0; i < stations.GetN(); ++i)
+    {
+        double angle = 2 * M_PI * i / stations.GetN();
+        positions->Add(Vector(distance * std::cos(angle), distance * std::sin(angle), 0));
+    }
+    MobilityHelper mobility;
+    mobility.SetPositionAllocator(positions);
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(link);
+
+    std::vector<Mac48Address> addresses;
+    std::vector<std::pair<std::string, Ptr<WifiNetDevice>>> stationDevices;
+    for (uint32_t i = 1; i < devices.GetN(); ++i)
+    {
+        addresses.push_back(Mac48Address::ConvertFrom(devices.Get(i)->GetAddress()));
+        stationDevices.emplace_back(Names::FindName(link.Get(i)),
+                                    DynamicCast<WifiNetDevice>(devices.Get(i)));
+    }
+
+    if (conversion)
+    {
+        TrafficControlHelper tch;
+        tch.SetRootQueueDisc("MulticastToUnicastQueueDisc");
+        QueueDiscContainer discs = tch.Install(devices.Get(0));
+        auto converter = DynamicCast<MulticastToUnicastQueueDisc>(discs.Get(0));
+        converter->SetStations(addresses);
+    }
+
+    m_wifiMonitor.Install(name, DynamicCast<WifiNetDevice>(devices.Get(0)), stationDevices);
+
+    if (!m_pcap.empty())
+    {
+        phy.EnablePcap(m_pcap + "-" + name, devices);
+    }
+
+    return devices;
 }
 
 uint32_t
@@ -354,3 +809,479 @@ Topology::GetAddressOnLink(Ptr<Node> node, const std::string& link)
     NS_FATAL_ERROR("Node " << Names::FindName(node) << " not found on link: " << link);
     return Ipv4Address();
 }
+
+Ipv4Address
+Topology::GetNodeAddress(Ptr<Node> node)
+{
+    auto ipv4 = node->GetObject<Ipv4>();
+    if (ipv4->GetNInterfaces() < 2)
+    {
+        NS_FATAL_ERROR("Node " << Names::FindName(node) << " has no links");
+    }
+    return ipv4->GetAddress(1, 0).GetLocal();
+}
+
+Ptr<Node>
+Topology::FindNodeByAddress(Ipv4Address address) const
+{
+    for (auto& [name, link] : m_linkMap)
+    {
+        for (uint32_t i = 0; i < link.interfaces.GetN(); ++i)
+        {
+            if (link.interfaces.GetAddress(i) == address)
+            {
+                return link.devices.Get(i)->GetNode();
+            }
+        }
+    }
+    return nullptr;
+}
+
+uint32_t
+Topology::PathMtu(Ptr<Node> node, Ipv4Address destination) const
+{
+    // Follow the unicast routes hop by hop and keep the smallest egress MTU,
+    // which is what an ideal path MTU discovery would converge to.
+    uint32_t mtu = 0;
+    for (uint32_t hops = 0; node && hops < 64; ++hops)
+    {
+        auto ipv4 = node->GetObject<Ipv4>();
+        if (ipv4->GetInterfaceForAddress(destination) != -1)
+        {
+            break;
+        }
+
+        Ipv4Header header;
+        header.SetDestination(destination);
+        Socket::SocketErrno error;
+        Ptr<Ipv4Route> route =
+            ipv4->GetRoutingProtocol()->RouteOutput(nullptr, header, nullptr, error);
+        if (!route)
+        {
+            return 0;
+        }
+
+        uint32_t egress = route->GetOutputDevice()->GetMtu();
+        mtu = mtu ? std::min(mtu, egress) : egress;
+
+        if (route->GetGateway() == Ipv4Address::GetZero())
+        {
+            break;
+        }
+        node = FindNodeByAddress(route->GetGateway());
+    }
+    return mtu;
+}
+
+void
+Topology::InstallPimDm()
+{
+    Ipv4StaticRoutingHelper staticRouting;
+    ObjectFactory factory;
+    factory.SetTypeId("PimDmRouting");
+
+    for (auto& [name, node] : m_nodeMap)
+    {
+        // Interface 0 is the loopback.
+        auto ipv4 = node->GetObject<Ipv4>();
+        if (ipv4->GetNInterfaces() > 2)
+        {
+            auto list = DynamicCast<Ipv4ListRouting>(ipv4->GetRoutingProtocol());
+            if (!list)
+            {
+                NS_FATAL_ERROR("Node " << name << " does not use list routing");
+            }
+            auto pim = factory.Create<PimDmRouting>();
+            list->AddRoutingProtocol(pim, 10);
+            m_pimRouters[name] = pim;
+        }
+        else if (ipv4->GetNInterfaces() == 2)
+        {
+            staticRouting.GetStaticRouting(ipv4)->SetDefaultMulticastRoute(1);
+        }
+    }
+}
+
+void
+Topology::ScheduleMembership(Ptr<Node> member,
+                             const std::vector<std::string>& groups,
+                             double start,
+                             double stop)
+{
+    if (m_pimRouters.empty())
+    {
+        return;
+    }
+
+    // Stands in for IGMP. Without Asserts every router told of a member
+    // would forward to it, so only the member's own router and its next hop
+    // towards the source learn of the membership.
+    std::string name = Names::FindName(member);
+    Ptr<PimDmRouting> upstream;
+    uint32_t upstreamInterface = 0;
+
+    Ipv4Header header;
+    header.SetDestination(m_mcSourceAddress);
+    Socket::SocketErrno error;
+    Ptr<Ipv4RoutingProtocol> routing = member->GetObject<Ipv4>()->GetRoutingProtocol();
+    Ptr<Ipv4Route> route = routing->RouteOutput(nullptr, header, nullptr, error);
+    if (route && route->GetGateway() != Ipv4Address::GetAny())
+    {
+        Ptr<Node> router = FindNodeByAddress(route->GetGateway());
+        auto it = router ? m_pimRouters.find(Names::FindName(router)) : m_pimRouters.end();
+        if (it != m_pimRouters.end())
+        {
+            upstream = it->second;
+            upstreamInterface =
+                router->GetObject<Ipv4>()->GetInterfaceForAddress(route->GetGateway());
+        }
+    }
+
+    for (auto& g : groups)
+    {
+        Ipv4Address group(g.c_str());
+
+        auto self = m_pimRouters.find(name);
+        if (self != m_pimRouters.end())
+        {
+            Simulator::Schedule(Seconds(start),
+                                &PimDmRouting::AddLocalMembership,
+                                self->second,
+                                group);
+            Simulator::Schedule(Seconds(stop),
+                                &PimDmRouting::RemoveLocalMembership,
+                                self->second,
+                                group);
+        }
+        if (upstream)
+        {
+            Simulator::Schedule(Seconds(start),
+                                &PimDmRouting::AddMembership,
+                                upstream,
+                                upstreamInterface,
+                                group);
+            Simulator::Schedule(Seconds(stop),
+                                &PimDmRouting::RemoveMembership,
+                                upstream,
+                                upstreamInterface,
+                                group);
+        }
+    }
+}
+
+void
+Topology::SinkRx(std::map<std::string, Time>* firstRx,
+                 std::string node,
+                 Ptr<const Packet>,
+                 const Address&)
+{
+    firstRx->try_emplace(node, Simulator::Now());
+}
+
+double
+Topology::GetJoinLatency(const std::string& node) const
+{
+    auto rx = m_sinkFirstRx.find(node);
+    if (rx == m_sinkFirstRx.end())
+    {
+        return -1;
+    }
+
+    // Time from the moment data could first have flowed to the sink: the
+    // later of its own start and the earliest source start.
+    double join = 0;
+    double sourceStart = -1;
+    for (auto& app : m_apps)
+    {
+        if (app.type == "PacketSink" && app.node == node)
+        {
+            join = app.start;
+        }
+        if (app.type == "OnOff" || app.type == "LoadGen" || app.type == "TraceReplay")
+        {
+            sourceStart = sourceStart < 0 ? app.start : std::min(sourceStart, app.start);
+        }
+    }
+    return rx->second.GetSeconds() - std::max(join, sourceStart);
+}
+
+void
+Topology::Report()
+{
+    auto reportStart = std::chrono::steady_clock::now();
+
+    m_linkMonitor.Report(Simulator::Now());
+    m_wifiMonitor.Report(Simulator::Now());
+    m_queueMonitor.Report();
+    if (!m_queueLog.empty())
+    {
+        m_queueMonitor.Write(m_queueLog);
+    }
+
+    if (!m_relayApps.empty())
+    {
+        std::cout << "relay report" << std::endl;
+
+        double sum = 0;
+        double sumSquares = 0;
+        for (auto& [name, relay] : m_relayApps)
+        {
+            std::cout << "  " << name << " (" << relay->GetRelayAddress() << "): "
+                      << relay->GetTotalPackets() << " packets, " << relay->GetTotalBytes()
+                      << " bytes, " << relay->GetTunnelSetups() << " tunnel setups, peak "
+                      << relay->GetPeakTunnels() << " tunnels" << std::endl;
+
+            auto bytes = static_cast<double>(relay->GetTotalBytes());
+            sum += bytes;
+            sumSquares += bytes * bytes;
+        }
+
+        // Jain's fairness index over the bytes each relay carried.
+        double fairness = sumSquares > 0 ? sum * sum / (m_relayApps.size() * sumSquares) : 1.0;
+        std::cout << "  load fairness: " << fairness << std::endl;
+
+        uint64_t sent = 0;
+        uint64_t fragmented = 0;
+        uint64_t fragments = 0;
+        uint64_t oversize = 0;
+        for (auto& [name, relay] : m_relayApps)
+        {
+            std::cout << "  " << name << " tunnel mtu " << relay->GetMinTunnelMtu() << ": "
+                      << relay->GetFragmented() << " above the path mtu, fragmented into "
+                      << relay->GetFragments() << " fragments, " << relay->GetOversizeDrops()
+                      << " dropped oversize" << std::endl;
+            if (relay->GetSentFragmented() > 0)
+            {
+                std::cout << "    fragmented by the relay itself: " << relay->GetSentFragmented()
+                          << " datagrams into " << relay->GetSentFragments() << " fragments"
+                          << std::endl;
+            }
+
+            sent += relay->GetTotalPackets();
+            fragmented += relay->GetFragmented();
+            fragments += relay->GetFragments();
+            oversize += relay->GetOversizeDrops();
+        }
+        if (sent + oversize > 0)
+        {
+            // Each fragmented datagram is replaced by its fragments on the wire.
+            double wirePackets = sent - fragmented + fragments;
+            double offered = sent + oversize;
+            std::cout << "  fragmentation: " << 100.0 * fragmented / offered
+                      << "% of tunnel datagrams fragmented on the path, "
+                      << 100.0 * oversize / offered << "% dropped oversize, "
+                      << wirePackets / std::max<uint64_t>(sent, 1)
+                      << " packets on the wire per datagram" << std::endl;
+        }
+    }
+
+    if (!m_gatewayApps.empty())
+    {
+        std::cout << "gateway report" << std::endl;
+        for (auto& [name, gateway] : m_gatewayApps)
+        {
+            std::cout << "  " << name << ": " << gateway->GetTotalPackets() << " packets, "
+                      << gateway->GetDuplicates() << " duplicates dropped, "
+                      << gateway->GetInvalidPackets() << " invalid, " << gateway->GetFailovers()
+                      << " failovers";
+            if (gateway->GetFailovers() > 0)
+            {
+                std::cout << " (total " << gateway->GetFailoverTime().GetSeconds() << "s, max "
+                          << gateway->GetMaxFailoverTime().GetSeconds() << "s)";
+            }
+            std::cout << std::endl;
+
+            if (gateway->GetFragmentsReceived() > 0)
+            {
+                std::cout << "    " << gateway->GetFragmentsReceived() << " fragments, "
+                          << gateway->GetReassembled() << " datagrams reassembled, "
+                          << gateway->GetReassemblyTimeouts() << " reassembly timeouts"
+                          << std::endl;
+            }
+        }
+
+        // Datagrams sent above the path MTU that never came out of
+        // reassembly were lost to a missing fragment, wherever on the path
+        // they were fragmented.
+        uint64_t fragmented = 0;
+        uint64_t reassembled = 0;
+        for (auto& [name, relay] : m_relayApps)
+        {
+            fragmented += relay->GetFragmented();
+        }
+        for (auto& [name, gateway] : m_gatewayApps)
+        {
+            reassembled += gateway->GetReassembled();
+        }
+        if (fragmented > 0)
+        {
+            uint64_t lost = fragmented > reassembled ? fragmented - reassembled : 0;
+            std::cout << "  fragmentation loss: " << lost << " of " << fragmented << " ("
+                      << 100.0 * lost / fragmented << "%)" << std::endl;
+        }
+    }
+
+    if (!m_replayApps.empty())
+    {
+        std::cout << "trace replay report" << std::endl;
+        for (auto& [name, replay] : m_replayApps)
+        {
+            std::cout << "  " << name << ": " << replay->GetTotalPackets() << " packets, "
+                      << replay->GetTotalBytes() << " bytes" << std::endl;
+        }
+    }
+
+    if (!m_loadApps.empty())
+    {
+        std::cout << "load generator report" << std::endl;
+        for (auto& [name, load] : m_loadApps)
+        {
+            std::cout << "  " << name << ": " << load->GetTotalPackets() << " packets, "
+                      << load->GetTotalBytes() << " bytes" << std::endl;
+        }
+    }
+
+    if (!m_sinkApps.empty())
+    {
+        std::cout << "sink report" << std::endl;
+        for (auto& [name, sink] : m_sinkApps)
+        {
+            std::cout << "  " << name << ": " << sink->GetTotalRx() << " bytes";
+            double latency = GetJoinLatency(name);
+            if (latency >= 0)
+            {
+                std::cout << ", join latency " << latency << "s";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    if (!m_pimRouters.empty())
+    {
+        std::cout << "pim report" << std::endl;
+
+        uint64_t controlBytes = 0;
+        for (auto& [name, pim] : m_pimRouters)
+        {
+            auto& sent = pim->GetSent();
+            std::cout << "  " << name << ": " << pim->GetNeighbors() << " neighbors, "
+                      << pim->GetEntries() << " (S,G) entries, " << pim->GetForwardingInterfaces()
+                      << " forwarding / " << pim->GetPrunedInterfaces()
+                      << " pruned interfaces, sent " << sent.hellos << " hello " << sent.joins
+                      << " join " << sent.prunes << " prune " << sent.grafts << " graft "
+                      << sent.graftAcks << " graft-ack (" << sent.bytes << " bytes), "
+                      << pim->GetForwarded() << " forwarded, " << pim->GetRpfFailures()
+                      << " rpf failures, " << pim->GetPruneOverrides() << " prune overrides"
+                      << std::endl;
+            controlBytes += sent.bytes;
+        }
+
+        // Asserts are not modelled: on a LAN with several upstream routers
+        // each of them keeps forwarding, so the data byte-hops, and with them
+        // sink byte counts, include the duplicates and the overhead reads low.
+        uint64_t dataBytes = 0;
+        for (auto& [name, link] : m_linkMonitor.GetCounters())
+        {
+            dataBytes += link.multicastBytes;
+        }
+        if (controlBytes + dataBytes > 0)
+        {
+            std::cout << "  control overhead: " << controlBytes << " bytes, "
+                      << 100.0 * controlBytes / (controlBytes + dataBytes)
+                      << "% of multicast byte-hops" << std::endl;
+        }
+    }
+
+    if (!m_results.IsOpen())
+    {
+        return;
+    }
+
+    Time now = Simulator::Now();
+    m_linkMonitor.Record(m_results, now);
+    m_wifiMonitor.Record(m_results);
+    m_queueMonitor.Record(m_results);
+
+    for (auto& [name, relay] : m_relayApps)
+    {
+        m_results.AddMetric("relay", name, "packets", relay->GetTotalPackets());
+        m_results.AddMetric("relay", name, "bytes", relay->GetTotalBytes());
+        m_results.AddMetric("relay", name, "tunnel_setups", relay->GetTunnelSetups());
+        m_results.AddMetric("relay", name, "peak_tunnels", relay->GetPeakTunnels());
+        m_results.AddMetric("relay", name, "tunnel_mtu", relay->GetMinTunnelMtu());
+        m_results.AddMetric("relay", name, "fragmented", relay->GetFragmented());
+        m_results.AddMetric("relay", name, "fragments", relay->GetFragments());
+        m_results.AddMetric("relay", name, "sent_fragmented", relay->GetSentFragmented());
+        m_results.AddMetric("relay", name, "sent_fragments", relay->GetSentFragments());
+        m_results.AddMetric("relay", name, "oversize_drops", relay->GetOversizeDrops());
+    }
+    for (auto& [name, gateway] : m_gatewayApps)
+    {
+        m_results.AddMetric("gateway", name, "packets", gateway->GetTotalPackets());
+        m_results.AddMetric("gateway", name, "duplicates", gateway->GetDuplicates());
+        m_results.AddMetric("gateway", name, "invalid", gateway->GetInvalidPackets());
+        m_results.AddMetric("gateway", name, "failovers", gateway->GetFailovers());
+        m_results.AddMetric("gateway",
+                            name,
+                            "failover_time",
+                            gateway->GetFailoverTime().GetSeconds());
+        m_results.AddMetric("gateway",
+                            name,
+                            "max_failover_time",
+                            gateway->GetMaxFailoverTime().GetSeconds());
+        m_results.AddMetric("gateway", name, "fragments", gateway->GetFragmentsReceived());
+        m_results.AddMetric("gateway", name, "reassembled", gateway->GetReassembled());
+        m_results.AddMetric("gateway",
+                            name,
+                            "reassembly_timeouts",
+                            gateway->GetReassemblyTimeouts());
+    }
+    for (auto& [name, replay] : m_replayApps)
+    {
+        m_results.AddMetric("replay", name, "packets", replay->GetTotalPackets());
+        m_results.AddMetric("replay", name, "bytes", replay->GetTotalBytes());
+    }
+    for (auto& [name, load] : m_loadApps)
+    {
+        m_results.AddMetric("loadgen", name, "packets", load->GetTotalPackets());
+        m_results.AddMetric("loadgen", name, "bytes", load->GetTotalBytes());
+    }
+    for (auto& [name, sink] : m_sinkApps)
+    {
+        m_results.AddMetric("sink", name, "bytes", sink->GetTotalRx());
+        m_results.AddMetric("sink",
+                            name,
+                            "throughput",
+                            sink->GetTotalRx() * 8.0 / now.GetSeconds());
+        double latency = GetJoinLatency(name);
+        if (latency >= 0)
+        {
+            m_results.AddMetric("sink", name, "join_latency", latency);
+        }
+    }
+    for (auto& [name, pim] : m_pimRouters)
+    {
+        auto& sent = pim->GetSent();
+        m_results.AddMetric("pim", name, "neighbors", pim->GetNeighbors());
+        m_results.AddMetric("pim", name, "entries", pim->GetEntries());
+        m_results.AddMetric("pim", name, "forwarding_interfaces", pim->GetForwardingInterfaces());
+        m_results.AddMetric("pim", name, "pruned_interfaces", pim->GetPrunedInterfaces());
+        m_results.AddMetric("pim", name, "hellos", sent.hellos);
+        m_results.AddMetric("pim", name, "joins", sent.joins);
+        m_results.AddMetric("pim", name, "prunes", sent.prunes);
+        m_results.AddMetric("pim", name, "grafts", sent.grafts);
+        m_results.AddMetric("pim", name, "graft_acks", sent.graftAcks);
+        m_results.AddMetric("pim", name, "control_bytes", sent.bytes);
+        m_results.AddMetric("pim", name, "forwarded", pim->GetForwarded());
+        m_results.AddMetric("pim", name, "rpf_failures", pim->GetRpfFailures());
+        m_results.AddMetric("pim", name, "prune_overrides", pim->GetPruneOverrides());
+    }
+
+    // The simulator runs between the end of the constructor and the first
+    // report, so that gap is the run phase.
+    auto reportEnd = std::chrono::steady_clock::now();
+    m_results.AddTiming("setup", SecondsBetween(m_wallStart, m_setupEnd));
+    m_results.AddTiming("run", SecondsBetween(m_setupEnd, reportStart));
+    m_results.AddTiming("report", SecondsBetween(reportStart, reportEnd));
+    m_results.Commit(SecondsBetween(m_wallStart, reportEnd), now.GetSeconds());
+}
@@ -0,0 +1,201 @@
+#include "wifi-monitor.h"
+
+#include <ns3/callback.h>
+#include <ns3/mac48-address.h>
+#include <ns3/nstime.h>
+#include <ns3/packet.h>
+#include <ns3/ptr.h>
+#include <ns3/simulator.h>
+#include <ns3/wifi-mac-header.h>
+#include <ns3/wifi-mac.h>
+#include <ns3/wifi-net-device.h>
+#include <ns3/wifi-phy-state-helper.h>
+#include <ns3/wifi-phy.h>
+
+#include <cstdint>
+#include <iomanip>
+#include <ios>
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+void
+WifiMonitor::Install(const std::string& link,
+                     Ptr<WifiNetDevice> ap,
+                     const std::vector<std::pair<std::string, Ptr<WifiNetDevice>>>& stations)
+{
+    Segment& segment = m_segments[link];
+
+    // Trace callbacks keep pointers into the vector, so it is filled before
+    // anything is connected and never resized afterwards.
+    segment.stations.resize(stations.size());
+    for (size_t i = 0; i < stations.size(); ++i)
+    {
+        segment.stations[i].node = stations[i].first;
+        segment.stations[i].address = Mac48Address::ConvertFrom(stations[i].second->GetAddress());
+    }
+
+    for (size_t i = 0; i < stations.size(); ++i)
+    {
+        stations[i].second->GetMac()->TraceConnectWithoutContext(
+            "MacRx",
+            MakeBoundCallback(&WifiMonitor::MacRx, &segment.stations[i]));
+    }
+
+    Ptr<WifiPhy> phy = ap->GetPhy();
+    phy->TraceConnectWithoutContext("PhyTxBegin",
+                                    MakeBoundCallback(&WifiMonitor::PhyTxBegin, &segment));
+    phy->GetState()->TraceConnectWithoutContext(
+        "State",
+        MakeBoundCallback(&WifiMonitor::PhyState, &segment));
+}
+
+void
+WifiMonitor::MacRx(Station* station, Ptr<const Packet> p)
+{
+    Time now = Simulator::Now();
+    if (station->packets == 0)
+    {
+        station->firstRx = now;
+    }
+    station->lastRx = now;
+    ++station->packets;
+    station->bytes += p->GetSize();
+}
+
+void
+WifiMonitor::PhyTxBegin(Segment* segment, Ptr<const Packet> p, double txPowerW)
+{
+    WifiMacHeader header;
+    p->PeekHeader(header);
+
+    Time now = Simulator::Now();
+    if (segment->pendingTx && segment->txAt == now)
+    {
+        segment->pendingTx = false;
+        Account(*segment, header.GetAddr1(), header.IsData(), segment->txDuration);
+        return;
+    }
+
+    segment->pendingFrame = true;
+    segment->frameAt = now;
+    segment->frameReceiver = header.GetAddr1();
+    segment->frameData = header.IsData();
+}
+
+void
+WifiMonitor::PhyState(Segment* segment, Time start, Time duration, WifiPhyState state)
+{
+    if (state != WifiPhyState::TX)
+    {
+        return;
+    }
+
+    Time now = Simulator::Now();
+    if (segment->pendingFrame && segment->frameAt == now)
+    {
+        segment->pendingFrame = false;
+        Account(*segment, segment->frameReceiver, segment->frameData, duration);
+        return;
+    }
+
+    segment->pendingTx = true;
+    segment->txAt = now;
+    segment->txDuration = duration;
+}
+
+void
+WifiMonitor::Account(Segment& segment, Mac48Address receiver, bool data, Time duration)
+{
+    if (!data)
+    {
+        segment.otherAirtime += duration;
+        return;
+    }
+
+    if (receiver.IsGroup())
+    {
+        segment.multicastAirtime += duration;
+        return;
+    }
+
+    segment.unicastAirtime += duration;
+    for (auto& station : segment.stations)
+    {
+        if (station.address == receiver)
+        {
+            station.airtime += duration;
+            break;
+        }
+    }
+}
+
+double
+WifiMonitor::Station::Throughput() const
+{
+    double active = (lastRx - firstRx).GetSeconds();
+    return active > 0 ? bytes * 8.0 / active : 0.0;
+}
+
+void
+WifiMonitor::Report(Time duration) const
+{
+    if (m_segments.empty())
+    {
+        return;
+    }
+
+    std::cout << "wifi report" << std::endl;
+    std::ios format(nullptr);
+    format.copyfmt(std::cout);
+    double elapsed = duration.GetSeconds();
+    for (auto& [name, segment] : m_segments)
+    {
+        double multicast = segment.multicastAirtime.GetSeconds();
+        double unicast = segment.unicastAirtime.GetSeconds();
+        double other = segment.otherAirtime.GetSeconds();
+
+        std::cout << "  " << name << ": ap airtime " << std::fixed << std::setprecision(2)
+                  << 100 * (multicast + unicast + other) / elapsed << "% (multicast "
+                  << 100 * multicast / elapsed << "%, unicast " << 100 * unicast / elapsed
+                  << "%, management " << 100 * other / elapsed << "%)" << std::endl;
+
+        for (auto& station : segment.stations)
+        {
+            double throughput = station.Throughput() / 1e6;
+            // Every station receives each group addressed frame, so each is
+            // charged the whole multicast airtime.
+            double airtime = station.airtime.GetSeconds() + multicast;
+
+            std::cout << "    " << station.node << ": " << station.packets << " packets, "
+                      << station.bytes << " bytes, " << throughput << " Mbps, airtime "
+                      << airtime * 1000 << " ms (" << 100 * airtime / elapsed << "%)"
+                      << std::endl;
+        }
+    }
+    std::cout.copyfmt(format);
+}
+
+void
+WifiMonitor::Record(ResultStore& store) const
+{
+    for (auto& [name, segment] : m_segments)
+    {
+        double multicast = segment.multicastAirtime.GetSeconds();
+        store.AddMetric("wifi", name, "multicast_airtime", multicast);
+        store.AddMetric("wifi", name, "unicast_airtime", segment.unicastAirtime.GetSeconds());
+        store.AddMetric("wifi", name, "management_airtime", segment.otherAirtime.GetSeconds());
+
+        for (auto& station : segment.stations)
+        {
+            store.AddMetric("station", station.node, "packets", station.packets);
+            store.AddMetric("station", station.node, "bytes", station.bytes);
+            store.AddMetric("station", station.node, "throughput", station.Throughput());
+            store.AddMetric("station",
+                            station.node,
+                            "airtime",
+                            station.airtime.GetSeconds() + multicast);
+        }
+    }
+}